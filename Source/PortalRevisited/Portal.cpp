@@ -12,6 +12,14 @@
 #include "PortalUtil.h"
 #include "PortalRevisitedCharacter.h"
 #include "PortalClipLocation.h"
+#include "PortalCharacterMovementComponent.h"
+#include "PortalDebugOverlay.h"
+#include "PortalPhysicsTeleport.h"
+#include "PortalProjectileMovementComponent.h"
+#include "PortalSnapshot.h"
+#include "PortalStats.h"
+#include "PortalTrace.h"
+#include "PortalSubsystem.h"
 #include "RenderingThread.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -25,6 +33,7 @@
 #include "Exporters/TextureExporterTGA.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
 #include "Serialization/BufferArchive.h"
 
 DEFINE_LOG_CATEGORY(Portal);
@@ -34,15 +43,30 @@ using Asset = ConstructorHelpers::FObjectFinder<T>;
 
 constexpr uint8 DEFAULT_STENCIL_VALUE = 1;
 constexpr int PORTAL_MAX_RECURSION = 2;
+static_assert(PORTAL_MAX_RECURSION == 2, "Each recursion depth has its own capture stat.");
+constexpr float PORTAL_SEEN_TOLERANCE = 0.2f;
+// Seconds between the same log of the per-frame work.
+constexpr double PORTAL_LOG_INTERVAL = 1.0;
 
 // Sets default values
 APortal::APortal()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Per-frame work is run by UPortalSubsystem for both portals of a pair.
+	PrimaryActorTick.bCanEverTick = false;
 
 	SetMobility(EComponentMobility::Movable);
 
+	TraversalCheckInterval = 0.f;
+	TimeSinceTraversalCheck = 0.f;
+
+	CloneExitMargin = 30.f;
+	CloneRetentionTime = 0.25f;
+	AvoidedCloneCycles = 0;
+	bWakeRequested = false;
+	bPhysicsThreadTeleport = false;
+	NumTeleports = 0;
+	TotalTeleportLatencyFrames = 0;
+
 	RootComponent->SetRelativeRotation(
 		FRotator::MakeFromEuler(
 			FVector(0.0, 0.0, 0.0)));
@@ -222,43 +246,129 @@ void APortal::BeginPlay()
 	Super::BeginPlay();
 }
 
-// Called every frame
-void APortal::Tick(float DeltaTime)
+void APortal::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
 {
-	Super::Tick(DeltaTime);
+	Super::AddReferencedObjects(InThis, Collector);
 
-	if (!bIsActivated)
-		return;
+	CastChecked<APortal>(InThis)->Tracked.AddReferencedObjects(Collector);
+}
+
+void APortal::MakeSnapshot(float DeltaTime, FPortalSnapshot& Snapshot)
+{
+	Snapshot.Reset();
+	Snapshot.Frame = FPortalFrame::Make(*this);
+	Snapshot.bActivated = bIsActivated;
+
+	if (FPortalDebugOverlay::IsEnabled(EPortalDebugCategory::Frames))
+	{
+		const auto& Frame = Snapshot.Frame;
+		FPortalDebugOverlay::Printf(
+			EPortalDebugCategory::Frames,
+			static_cast<int32>(GetUniqueID()),
+			TEXT("Portal %u: (%.0f, %.0f, %.0f) forward (%.2f, %.2f, %.2f) up (%.2f, %.2f, %.2f)"),
+			GetUniqueID(),
+			Frame.PlaneLocation.X, Frame.PlaneLocation.Y, Frame.PlaneLocation.Z,
+			Frame.Forward.X, Frame.Forward.Y, Frame.Forward.Z,
+			Frame.Up.X, Frame.Up.Y, Frame.Up.Z);
+	}
+
+	// The frame after activation has run, so the portal
+	// sleeps from now on until something happens.
+	bWakeRequested = false;
 
-	UpdateClones();
-	LinkedPortal->UpdateClones();
-	UpdateCapture(DeltaTime);
-	CheckAndTeleportOverlappingActors();
+	// Crossings are swept from the last checked location, so the check
+	// may run less often than the tick without missing any crossing.
+	if (bIsActivated)
+	{
+		TimeSinceTraversalCheck += DeltaTime;
+		if (TimeSinceTraversalCheck >= TraversalCheckInterval)
+		{
+			TimeSinceTraversalCheck = 0.f;
+			Snapshot.bCheckTraversal = true;
+		}
+	}
+
+	// Snapshot entries share the tracked indices,
+	// so destroyed actors are released before.
+	ReleaseDestroyedActors();
+
+	for (int32 i = 0; i < Tracked.Num(); ++i)
+	{
+		const auto& Original = Tracked.Originals[i];
+
+		Snapshot.Originals.Add(Original);
+		Snapshot.OriginalLocations.Add(Original->GetActorLocation());
+		Snapshot.OriginalQuats.Add(Original->GetActorQuat());
+		Snapshot.TrackedLocations.Add(Tracked.GetTrackedLocation(i));
+		Snapshot.LastLocations.Add(Tracked.LastLocations[i]);
+		Snapshot.LastLocationFrames.Add(Tracked.LastLocationFrames[i]);
+		Snapshot.Flags.Add(Tracked.Flags[i]);
+	}
 }
 
-void APortal::UpdateClones()
+bool APortal::HasWork() const
 {
-	for (auto [Original, Clone] : CloneMap)
+	return bWakeRequested || !Tracked.IsEmpty() || IsSeen();
+}
+
+bool APortal::IsSeen() const
+{
+	// The renderer stamps the plane when any view draws it, so an
+	// unseen portal costs only this comparison.
+	return bIsActivated &&
+		PortalPlane->WasRecentlyRendered(PORTAL_SEEN_TOLERANCE);
+}
+
+bool APortal::IsSnapshotEntryValid(const FPortalSnapshot& Snapshot, int32 TrackedIndex) const
+{
+	// Overlap events during the commit may have changed the entries.
+	return Tracked.Originals.IsValidIndex(TrackedIndex) &&
+		Tracked.Originals[TrackedIndex] == Snapshot.Originals[TrackedIndex] &&
+		IsValid(Tracked.Originals[TrackedIndex]);
+}
+
+void APortal::CommitClones(const FPortalSnapshot& Snapshot, const FPortalResult& Result)
+{
+	PORTAL_SCOPE_CYCLE_COUNTER(UpdateClones);
+
+	for (int32 i = 0; i < Snapshot.Originals.Num(); ++i)
 	{
-		if (!Clone)
+		if (!IsSnapshotEntryValid(Snapshot, i))
+			continue;
+
+		const auto& Original = Tracked.Originals[i];
+		const auto& Clone = Tracked.Clones[i];
+
+		if (!IsValid(Clone))
 			continue;
 
-		auto CloneLocation =
-			TransformPointToDestSpace(Original->GetActorLocation());
-		Clone->SetActorLocation(CloneLocation);
+		PORTAL_INC_COUNTER(Clones, 1);
+
+		const auto& CloneLocation = Result.CloneLocations[i];
+		const auto& CloneRotation = Result.CloneQuats[i];
+
+		if (FPortalDebugOverlay::IsEnabled(EPortalDebugCategory::Clones))
+		{
+			const auto CloneRotator = CloneRotation.Rotator();
+			FPortalDebugOverlay::Printf(
+				EPortalDebugCategory::Clones,
+				static_cast<int32>(Clone->GetUniqueID()),
+				TEXT("Clone %u: (%.0f, %.0f, %.0f) pitch %.1f yaw %.1f roll %.1f"),
+				Clone->GetUniqueID(),
+				CloneLocation.X, CloneLocation.Y, CloneLocation.Z,
+				CloneRotator.Pitch, CloneRotator.Yaw, CloneRotator.Roll);
+		}
 
 		// If the clone is the player, set rotation and velocity
 		// by different way.
-		if (const auto OriginalPlayer =
-			Cast<APortalRevisitedCharacter>(Original))
+		if (Tracked.Kinds[i] == EPortalTrackedKind::Player)
 		{
-			auto ClonePlayer =
-				Cast<APortalRevisitedCharacter>(Clone);
+			const auto OriginalPlayer =
+				static_cast<APortalRevisitedCharacter*>(Original.Get());
+			const auto ClonePlayer =
+				static_cast<APortalRevisitedCharacter*>(Clone.Get());
 
-			auto OriginalController = OriginalPlayer->GetController();
-			const auto CloneRotation =
-				TransformQuatToDestSpace(
-					OriginalPlayer->GetActorRotation().Quaternion());
+			ClonePlayer->SetActorLocation(CloneLocation);
 
 			ClonePlayer->GetMovementComponent()->Velocity = 
 				OriginalPlayer->GetMovementComponent()->Velocity;
@@ -271,23 +381,178 @@ void APortal::UpdateClones()
 			continue;
 		}
 
-		auto CloneRotation =
-			TransformQuatToDestSpace(Original->GetActorQuat());
-		Clone->SetActorRotation(CloneRotation);
+		// Not a teleport, so the kinematic target of the clone gets
+		// the velocity of this move and pushes bodies it touches.
+		Clone->SetActorLocationAndRotation(
+			CloneLocation,
+			CloneRotation,
+			false,
+			nullptr,
+			ETeleportType::None);
+	}
+}
+
+bool APortal::CommitTraversal(const FPortalSnapshot& Snapshot, const FPortalResult& Result)
+{
+	if (!Snapshot.bCheckTraversal)
+		return false;
+
+	PORTAL_SCOPE_CYCLE_COUNTER(Traversal);
+
+	// Advance the sweep of every entry checked before the crossing.
+	const auto NumChecked = Result.CrossedIndex == INDEX_NONE ?
+		Snapshot.Originals.Num() :
+		Result.CrossedIndex + 1;
+
+	for (int32 i = 0; i < NumChecked; ++i)
+	{
+		if (!IsSnapshotEntryValid(Snapshot, i))
+			continue;
+
+		if (EnumHasAnyFlags(Snapshot.Flags[i], EPortalTrackedFlags::HandlesTraversal))
+			continue;
+
+		Tracked.SetLastLocation(i, Snapshot.TrackedLocations[i]);
+	}
+
+	if (Result.CrossedIndex == INDEX_NONE ||
+		!IsSnapshotEntryValid(Snapshot, Result.CrossedIndex))
+	{
+		return false;
+	}
+
+	// The crossing happened after the location the snapshot swept from.
+	const auto LatencyFrames =
+		GFrameCounter - Snapshot.LastLocationFrames[Result.CrossedIndex];
+	TeleportTracked(Result.CrossedIndex, LatencyFrames);
+
+	return true;
+}
+
+bool APortal::PredictTraversal(float DeltaTime)
+{
+	if (!bIsActivated)
+		return false;
+
+	PORTAL_SCOPE_CYCLE_COUNTER(Traversal);
+
+	const auto PortalLocation = GetPortalPlaneLocation();
+	const auto PortalForward = GetPortalForwardVector();
+	const auto PortalRight = GetPortalRightVector();
+	const auto PortalUp = GetPortalUpVector();
+
+	for (int32 i = 0; i < Tracked.Num(); ++i)
+	{
+		if (EnumHasAnyFlags(Tracked.Flags[i], EPortalTrackedFlags::HandlesTraversal))
+			continue;
+
+		if (!IsValid(Tracked.Originals[i]) || !IsValid(Tracked.TrackedComponents[i]))
+			continue;
+
+		// Where the physics of this frame will move the actor.
+		const auto Location = Tracked.GetTrackedLocation(i);
+		const auto PredictedLocation =
+			Location + Tracked.Originals[i]->GetVelocity() * DeltaTime;
+
+		const auto bWillCrossPortal =
+			DoesSegmentCrossPortal(
+				Location,
+				PredictedLocation,
+				PortalLocation,
+				PortalForward,
+				PortalRight,
+				PortalUp);
+
+		// Teleport only single actor in a frame. The teleported actor
+		// is moved out of the linked portal by the same physics step.
+		if (bWillCrossPortal)
+		{
+			TeleportTracked(i, 0);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void APortal::TeleportTracked(int32 TrackedIndex, uint64 LatencyFrames)
+{
+	// Teleport may end the overlap and remove the entry,
+	// so keep what is needed after it.
+	const auto Actor = Tracked.Originals[TrackedIndex];
+	TeleportActor(
+		*Actor,
+		Tracked.Kinds[TrackedIndex],
+		Tracked.Primitives[TrackedIndex]);
+
+	++NumTeleports;
+	TotalTeleportLatencyFrames += LatencyFrames;
+
+	UE_LOG(Portal, Verbose, TEXT("Teleported %s %llu frames after crossing."),
+		*Actor->GetName(), LatencyFrames);
+
+	HandleActorPassed(Actor);
+}
+
+void APortal::SetPhysicsThreadTeleport(bool bNewPhysicsThreadTeleport)
+{
+	bPhysicsThreadTeleport = bNewPhysicsThreadTeleport;
+}
+
+void APortal::CollectPhysicsTeleportBodies(
+	bool bAtFirst,
+	TArray<FPortalPhysicsTeleportBody>& Bodies) const
+{
+	if (!bPhysicsThreadTeleport)
+		return;
 
-		auto PrimitiveCompOpt = GetPrimitiveComponent(Original);
-		if (!PrimitiveCompOpt)
+	for (int32 i = 0; i < Tracked.Num(); ++i)
+	{
+		if (Tracked.Kinds[i] != EPortalTrackedKind::Body ||
+			!EnumHasAnyFlags(Tracked.Flags[i], EPortalTrackedFlags::HandlesTraversal))
 		{
-			UE_LOG(Portal, Warning, TEXT("Cannot set velocity of the clone."))
 			continue;
 		}
-		
-		auto CloneVelocity = Original->GetVelocity();
-		auto PrimitiveComp = *PrimitiveCompOpt;
-		PrimitiveComp->SetPhysicsLinearVelocity(CloneVelocity);
+
+		const auto& Primitive = Tracked.Primitives[i];
+		if (!IsValid(Primitive))
+			continue;
+
+		const auto BodyInstance = Primitive->GetBodyInstance();
+		if (!BodyInstance || !BodyInstance->ActorHandle)
+			continue;
+
+		Bodies.Add(FPortalPhysicsTeleportBody{ BodyInstance->ActorHandle, bAtFirst });
 	}
 }
 
+void APortal::HandleBodyPassed(const IPhysicsProxyBase* Proxy)
+{
+	for (int32 i = 0; i < Tracked.Num(); ++i)
+	{
+		const auto& Primitive = Tracked.Primitives[i];
+		if (!IsValid(Primitive) || !IsValid(Tracked.Originals[i]))
+			continue;
+
+		const auto BodyInstance = Primitive->GetBodyInstance();
+		if (!BodyInstance || BodyInstance->ActorHandle != Proxy)
+			continue;
+
+		// Teleported at the physics step it crossed in.
+		++NumTeleports;
+		HandleActorPassed(Tracked.Originals[i]);
+		return;
+	}
+}
+
+float APortal::GetAverageTeleportLatencyFrames() const
+{
+	if (NumTeleports == 0)
+		return 0.f;
+
+	return static_cast<float>(TotalTeleportLatencyFrames) / NumTeleports;
+}
+
 APortal::LocationAndRotation APortal::CalculatePortalCameraLocationAndRotation(
 	const FVector& CameraLocation,
 	const FQuat& CameraQuat)
@@ -317,75 +582,68 @@ TObjectPtr<APortal> APortal::GetLink() const
 	return LinkedPortal;
 }
 
-void APortal::AddIgnoredActor(TObjectPtr<AActor> Actor)
+bool APortal::IsActivated() const
+{
+	return bIsActivated;
+}
+
+void APortal::SetHostSurface(TObjectPtr<UPrimitiveComponent> NewHostSurface)
 {
-	IgnoredActors.AddUnique(Actor);
+	HostSurface = NewHostSurface;
 }
 
-void APortal::RemoveIgnoredActor(TObjectPtr<AActor> Actor)
+TObjectPtr<UPrimitiveComponent> APortal::GetHostSurface() const
 {
-	IgnoredActors.Remove(Actor);
+	return HostSurface;
+}
+
+bool APortal::IsClone(const AActor* Actor) const
+{
+	return Tracked.FindClone(Actor) != INDEX_NONE ||
+		(LinkedPortal && LinkedPortal->Tracked.FindClone(Actor) != INDEX_NONE);
 }
 
 std::optional<TObjectPtr<AActor>> APortal::GetOriginalIfClone(AActor* Actor)
 {
-	for (auto [Original, Clone] : CloneMap)
-	{
-		if (Clone->GetUniqueID() == Actor->GetUniqueID())
-			return Original;
-	}
+	const auto Index = Tracked.FindClone(Actor);
+	if (Index == INDEX_NONE || !IsValid(Tracked.Originals[Index]))
+		return std::nullopt;
 
-	return std::nullopt;
+	return Tracked.Originals[Index];
 }
 
-void APortal::UpdateCapture(float DeltaTime)
+bool APortal::CommitClipParameters(const FPortalView& View, const FPortalResult& Result)
 {
+	if (!Result.bVisible)
+		return false;
+
 	if (!PortalCamera->TextureTarget)
 	{
-		UE_LOG(Portal, Error, TEXT("Update capture failed: Portal render target isn't set"));
-		return;
+		PORTAL_LOG_RATE_LIMITED(Portal, Error, PORTAL_LOG_INTERVAL, TEXT("Update capture failed: Portal render target isn't set"));
+		return false;
 	}
 
 	if (!LinkedPortal)
 	{
-		UE_LOG(Portal, Error, TEXT("Update capture failed: Portal isn't linked."));
-		return;
+		PORTAL_LOG_RATE_LIMITED(Portal, Error, PORTAL_LOG_INTERVAL, TEXT("Update capture failed: Portal isn't linked."));
+		return false;
 	}
 
-	// Get the Projection Matrix
-	const auto PlayerCameraManager =
-		GWorld->GetFirstPlayerController()->PlayerCameraManager;
-
 	// Set camera projection matrix of the portal camera.
-	FMatrix UnusedViewMatrix;
-	FMatrix ProjectionMatrix;
-	FMatrix ViewProjectionMatrix;
-	
-	UGameplayStatics::GetViewProjectionMatrix(
-		PlayerCameraManager->GetCameraCacheView(),
-		UnusedViewMatrix,
-		ProjectionMatrix,
-		ViewProjectionMatrix);
-
-	PortalCamera->CustomProjectionMatrix = ProjectionMatrix;
-
-	// Cannot see the portal.
-	if (UPortalClipLocation::CannotSeePortal(ViewProjectionMatrix,
-		this))
-	{
-		return;
-	}
+	PortalCamera->CustomProjectionMatrix = View.ProjectionMatrix;
 
-	auto PlayerCameraLocation = 
-		PlayerCameraManager->GetCameraLocation();
-	auto PlayerCameraRotation = 
-		PlayerCameraManager->GetCameraRotation().Quaternion();
+	return true;
+}
 
+void APortal::UpdateCapture(float DeltaTime, const FPortalView& View)
+{
+	PORTAL_SCOPE_CYCLE_COUNTER(UpdateCapture);
+	PORTAL_TRACE_SCOPE(Portal_UpdateCapture);
 
 	CapturePortalSceneRecur(
 		DeltaTime,
-		PlayerCameraLocation,
-		PlayerCameraRotation, 
+		View.Location,
+		View.Rotation, 
 		PORTAL_MAX_RECURSION);
 }
 
@@ -404,7 +662,7 @@ void APortal::CapturePortalSceneRecur(
 
 	if (!CameraLocationAndRotationOpt)
 	{
-		UE_LOG(Portal, Error, TEXT("Update capture failed."));
+		PORTAL_LOG_RATE_LIMITED(Portal, Error, PORTAL_LOG_INTERVAL, TEXT("Update capture failed."));
 		return;
 	}
 
@@ -421,6 +679,7 @@ void APortal::CapturePortalSceneRecur(
 		LinkedPortal->GetPortalPlaneLocation(), 
 		LinkedPortalForward))
 	{
+		PORTAL_INC_COUNTER(SkippedCaptures, 1);
 		return;
 	}
 
@@ -431,6 +690,7 @@ void APortal::CapturePortalSceneRecur(
 
 	if (CameraForward.Dot(LinkedPortalForward) < -0.666)
 	{
+		PORTAL_INC_COUNTER(SkippedCaptures, 1);
 		return;
 	}
 
@@ -460,16 +720,16 @@ void APortal::CapturePortalSceneRecur(
 	// cloned player.
 	if (RecursionRemaining == PORTAL_MAX_RECURSION)
 	{
-		for (auto [Original, Clone] : CloneMap)
+		for (int32 i = 0; i < Tracked.Num(); ++i)
 		{
-			if (!Clone)
+			const auto& Clone = Tracked.Clones[i];
+			if (!IsValid(Clone))
 				continue;
 			
-			if (const auto OriginalPlayer =
-				Cast<APortalRevisitedCharacter>(Original))
+			if (Tracked.Kinds[i] == EPortalTrackedKind::Player)
 			{
-				auto ClonePlayer =
-					Cast<APortalRevisitedCharacter>(Clone);
+				const auto ClonePlayer =
+					static_cast<APortalRevisitedCharacter*>(Clone.Get());
 
 				PortalCamera->HideComponent(ClonePlayer->GetMesh());
 			}
@@ -479,17 +739,17 @@ void APortal::CapturePortalSceneRecur(
 	{
 		// Not in the first capture, we should hide first person mesh
 		// of the clone player.
-		for (auto [Original, Clone] : CloneMap)
+		for (int32 i = 0; i < Tracked.Num(); ++i)
 		{
-			if (!Clone)
+			const auto& Clone = Tracked.Clones[i];
+			if (!IsValid(Clone))
 				continue;
 			
-			if (const auto OriginalPlayer =
-				Cast<APortalRevisitedCharacter>(Original))
+			if (Tracked.Kinds[i] == EPortalTrackedKind::Player)
 			{
-				auto ClonePlayer =
-					Cast<APortalRevisitedCharacter>(Clone);
-				
+				const auto ClonePlayer =
+					static_cast<APortalRevisitedCharacter*>(Clone.Get());
+
 				PortalCamera->HideComponent(ClonePlayer->GetMesh1P());
 			}
 		}
@@ -502,7 +762,24 @@ void APortal::CapturePortalSceneRecur(
 	PortalCamera->ClipPlaneBase = LinkedPortal->GetPortalPlaneLocation();
 	PortalCamera->ClipPlaneNormal = LinkedPortal->GetActorForwardVector();
 	
-	PortalCamera->CaptureScene();
+	{
+		// Timed per depth, as each depth renders the scene again.
+		const auto Depth = PORTAL_MAX_RECURSION - RecursionRemaining;
+		FScopeCycleCounter CaptureCycleCounter(Depth == 0 ?
+			GET_STATID(STAT_PortalCaptureScene0) :
+			GET_STATID(STAT_PortalCaptureScene1));
+#if CSV_PROFILER
+		FScopedCsvStat CaptureCsvStat(
+			Depth == 0 ? "CaptureScene0" : "CaptureScene1",
+			CSV_CATEGORY_INDEX(Portal));
+#endif
+		PORTAL_TRACE_SCOPE_TEXT(Depth == 0 ?
+			TEXT("Portal_CaptureScene0") :
+			TEXT("Portal_CaptureScene1"));
+
+		PortalCamera->CaptureScene();
+	}
+	PORTAL_INC_COUNTER(Captures, 1);
 	
 	// If the last recursion, we should set back the material.
 	if (RecursionRemaining == 1)
@@ -512,6 +789,9 @@ void APortal::CapturePortalSceneRecur(
 
 	if (RecursionRemaining > 2)
 		return;
+
+	PORTAL_SCOPE_CYCLE_COUNTER(UpdateClipLocation);
+
 	// In this case, we will save location of the farthest,
 	// and second farthest portal in the clip space. We can
 	// determine where the portal rectangle is in the render
@@ -574,47 +854,145 @@ void APortal::CapturePortalSceneRecur(
 		this);
 }
 
-void APortal::CheckAndTeleportOverlappingActors()
+void APortal::UpdateLeavingActors(float DeltaTime)
 {
-	for (int i = 0; i < OverlappingActors.Num(); ++i)
+	ReleaseDestroyedActors();
+
+	// Iterate backward, because releasing swaps the last entry in.
+	for (int32 i = Tracked.Num() - 1; i >= 0; --i)
 	{
-		auto OverlappingActor = OverlappingActors[i];
-		FVector ActorLocation;
-		
-		if (auto Player = 
-			Cast<APortalRevisitedCharacter>(OverlappingActor))
+		if (!EnumHasAnyFlags(Tracked.Flags[i], EPortalTrackedFlags::Leaving))
+			continue;
+
+		const auto Distance =
+			GetDistanceOutsideEnterMask(Tracked.GetTrackedLocation(i));
+
+		if (Distance <= CloneExitMargin)
 		{
-			ActorLocation = 
-				Player->GetFirstPersonCameraComponent()
-					->GetComponentLocation();
+			Tracked.TimesOutside[i] = 0.f;
+			continue;
 		}
-		else
+
+		Tracked.TimesOutside[i] += DeltaTime;
+		if (Tracked.TimesOutside[i] >= CloneRetentionTime)
 		{
-			ActorLocation = OverlappingActor->GetActorLocation();
+			UnregisterOverlappingActor(Tracked.Originals[i]);
 		}
-		const auto bAcrossedPortal = 
-			!IsPointInFrontOfPortal(
-				ActorLocation,
-				GetPortalPlaneLocation(),
-				GetPortalForwardVector());
+	}
+}
+
+float APortal::GetDistanceOutsideEnterMask(const FVector& Location) const
+{
+	const auto LocalLocation =
+		PortalEnterMask->GetComponentTransform().InverseTransformPositionNoScale(Location);
+	const auto Radius = PortalEnterMask->GetScaledCapsuleRadius();
+	const auto HalfHeight =
+		PortalEnterMask->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+
+	// Distance from the segment on the capsule axis, minus the radius.
+	const auto AxisZ =
+		FMath::Clamp(LocalLocation.Z, -HalfHeight, HalfHeight);
+	const auto Distance =
+		FVector(LocalLocation.X, LocalLocation.Y, LocalLocation.Z - AxisZ).Size() - Radius;
+
+	return FMath::Max(Distance, 0.0);
+}
+
+int32 APortal::GetAvoidedCloneCycles() const
+{
+	return AvoidedCloneCycles;
+}
+
+int32 APortal::GetNumTracked() const
+{
+	return Tracked.Num();
+}
 
-		if (bAcrossedPortal)
+SIZE_T APortal::GetRenderTargetBytes() const
+{
+	SIZE_T Bytes = 0;
+
+	for (const auto& Texture : { PortalTexture, PortalRecurTexture })
+	{
+		if (Texture)
 		{
-			//RemoveClone(OverlappingActor);
-			TeleportActor(*OverlappingActor);
-			PortalGun->OnActorPassedPortal(this, OverlappingActor);
-
-			// Play sound both side of the portals.
-			PlaySoundAtLocation(EnterSound, GetActorLocation());
-			LinkedPortal->PlaySoundAtLocation(
-				LinkedPortal->EnterSound,
-				LinkedPortal->GetActorLocation());
-			
-			return;
-			// Teleport only single actor in a tick
-			// to prevent side effects from changing array.
+			Bytes += Texture->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
 		}
 	}
+
+	return Bytes;
+}
+
+bool APortal::TeleportIfCrossed(int32 TrackedIndex)
+{
+	// The character movement moves the character through the portal
+	// by itself, in the same movement step it crosses.
+	if (EnumHasAnyFlags(
+		Tracked.Flags[TrackedIndex],
+		EPortalTrackedFlags::HandlesTraversal))
+	{
+		return false;
+	}
+
+	PORTAL_SCOPE_CYCLE_COUNTER(Traversal);
+
+	const auto CurrentLocation = Tracked.GetTrackedLocation(TrackedIndex);
+	const auto PreviousLocation = Tracked.LastLocations[TrackedIndex];
+	const auto LatencyFrames =
+		GFrameCounter - Tracked.LastLocationFrames[TrackedIndex];
+	Tracked.SetLastLocation(TrackedIndex, CurrentLocation);
+
+	// Sweep the tracked point from the last check to now, so a fast
+	// actor or a sparse check cannot jump over the portal plane.
+	const auto bAcrossedPortal =
+		DoesSegmentCrossPortal(
+			PreviousLocation,
+			CurrentLocation,
+			GetPortalPlaneLocation(),
+			GetPortalForwardVector(),
+			GetPortalRightVector(),
+			GetPortalUpVector());
+
+	if (!bAcrossedPortal)
+	{
+		return false;
+	}
+
+	TeleportTracked(TrackedIndex, LatencyFrames);
+
+	return true;
+}
+
+void APortal::HandleActorPassed(TObjectPtr<AActor> Actor)
+{
+	PORTAL_INC_COUNTER(Teleports, 1);
+	PORTAL_TRACE_BOOKMARK(TEXT("Portal teleport: %s through %s"), *Actor->GetName(), *GetName());
+
+	// The actor jumped to the other side, so the next sweep
+	// should start from the location after teleport.
+	ResetTrackedLocation(Actor);
+	LinkedPortal->ResetTrackedLocation(Actor);
+
+	// The actor is on the other side now, so its clone
+	// here is not retained.
+	UnregisterOverlappingActor(Actor);
+
+	PortalGun->OnActorPassedPortal(this, Actor);
+
+	// Play sound both side of the portals.
+	PlaySoundAtLocation(EnterSound, GetActorLocation());
+	LinkedPortal->PlaySoundAtLocation(
+		LinkedPortal->EnterSound,
+		LinkedPortal->GetActorLocation());
+}
+
+void APortal::ResetTrackedLocation(TObjectPtr<AActor> Actor)
+{
+	const auto Index = Tracked.FindOriginal(Actor);
+	if (Index != INDEX_NONE)
+	{
+		Tracked.SetLastLocation(Index, Tracked.GetTrackedLocation(Index));
+	}
 }
 
 void APortal::PlaySoundAtLocation(USoundBase* SoundToPlay, FVector Location)
@@ -625,8 +1003,13 @@ void APortal::PlaySoundAtLocation(USoundBase* SoundToPlay, FVector Location)
 	}
 }
 
-void APortal::TeleportActor(AActor& Actor)
+void APortal::TeleportActor(
+	AActor& Actor,
+	EPortalTrackedKind Kind,
+	UPrimitiveComponent* PrimitiveComponent)
 {
+	PORTAL_TRACE_SCOPE(Portal_TeleportActor);
+
 	const auto BeforeLocation = Actor.GetActorLocation();
 	const auto BeforeVelocity = Actor.GetVelocity();
 
@@ -641,10 +1024,11 @@ void APortal::TeleportActor(AActor& Actor)
 	
 	Actor.SetActorLocation(AfterLocation, false, nullptr, ETeleportType::None);
 	 
-	if (auto Player = 
-			Cast<APortalRevisitedCharacter>(&Actor))
+	if (Kind == EPortalTrackedKind::Player)
 	{
-		UE_LOG(Portal, Log, TEXT("The character teleported."));
+		const auto Player =
+			static_cast<APortalRevisitedCharacter*>(&Actor);
+		UE_LOG(Portal, Verbose, TEXT("The character teleported."));
 		auto Controller = Player->GetController();
 		const auto BefreControllerQuat = 
 			Controller->GetControlRotation().Quaternion();
@@ -667,31 +1051,84 @@ void APortal::TeleportActor(AActor& Actor)
 	Actor.SetActorRotation(AfterQuat);
 
 	Actor.GetRootComponent()->ComponentVelocity = AfterVelocity;
-	auto PrimitiveComponent = 
-		static_cast<UPrimitiveComponent*>(Actor.GetComponentByClass(UPrimitiveComponent::StaticClass()));
-	PrimitiveComponent->SetAllPhysicsLinearVelocity(AfterVelocity, false);
+	if (PrimitiveComponent)
+	{
+		PrimitiveComponent->SetAllPhysicsLinearVelocity(AfterVelocity, false);
+	}
 }
 
-void APortal::RemoveClone(TObjectPtr<AActor> Actor)
+void APortal::RemoveClone(int32 TrackedIndex)
 {
-	auto Clone = CloneMap.Find(Actor);
-	if (!Clone)
+	const auto Clone = Tracked.Clones[TrackedIndex];
+	if (!IsValid(Clone))
+	{
+		Tracked.ClearClone(TrackedIndex);
+		return;
+	}
+
+	PORTAL_TRACE_SCOPE(Portal_RemoveClone);
+	PORTAL_TRACE_BOOKMARK(TEXT("%s: clone %s of %s destroyed"),
+		*GetName(), *Clone->GetName(), *GetNameSafe(Tracked.Originals[TrackedIndex]));
+
+	// The player's clone is kept for the next approach.
+	if (Clone == PlayerClone)
 	{
+		Tracked.ClearClone(TrackedIndex);
+		SetPlayerCloneActive(false);
 		return;
 	}
 
 	TArray<AActor*> AttachedActors;
-	(*Clone)->GetAttachedActors(AttachedActors);
+	Clone->GetAttachedActors(AttachedActors);
 
 	for (auto AttachedActor : AttachedActors)
 	{
 		GWorld->DestroyActor(AttachedActor);
 	}
 	
-	CloneMap.Remove(Actor);
-	GWorld->DestroyActor(*Clone);
-	LinkedPortal->RemoveIgnoredActor(*Clone);
-	RemoveIgnoredActor(*Clone);
+	Tracked.ClearClone(TrackedIndex);
+	GWorld->DestroyActor(Clone);
+}
+
+void APortal::MakeCloneKinematic(TObjectPtr<AActor> Clone)
+{
+	const auto PrimitiveCompOpt = GetPrimitiveComponent(Clone);
+	if (!PrimitiveCompOpt)
+	{
+		UE_LOG(Portal, Warning, TEXT("Cannot make the clone kinematic: %s"), *Clone->GetName());
+		return;
+	}
+
+	const auto PrimitiveComp = *PrimitiveCompOpt;
+	PrimitiveComp->SetSimulatePhysics(false);
+	PrimitiveComp->SetNotifyRigidBodyCollision(true);
+	PrimitiveComp->OnComponentHit.AddUniqueDynamic(this, &APortal::OnCloneHit);
+}
+
+void APortal::OnCloneHit(
+	UPrimitiveComponent* HitComponent,
+	AActor* OtherActor,
+	UPrimitiveComponent* OtherComp,
+	FVector NormalImpulse,
+	const FHitResult& Hit)
+{
+	const auto TrackedIndex = Tracked.FindClone(HitComponent->GetOwner());
+	if (TrackedIndex == INDEX_NONE)
+		return;
+
+	// The original and the other clones are moved by their own bodies.
+	if (OtherActor == Tracked.Originals[TrackedIndex] || IsClone(OtherActor))
+		return;
+
+	const auto& OriginalComp = Tracked.Primitives[TrackedIndex];
+	if (!IsValid(OriginalComp) || !OriginalComp->IsSimulatingPhysics())
+		return;
+
+	// The clone is on the linked side, so the linked portal
+	// transforms the contact back to the original's side.
+	OriginalComp->AddImpulseAtLocation(
+		LinkedPortal->TransformVectorToDestSpace(NormalImpulse),
+		LinkedPortal->TransformPointToDestSpace(Hit.ImpactPoint));
 }
 
 void APortal::LinkPortals(TObjectPtr<APortal> NewTarget)
@@ -702,7 +1139,6 @@ void APortal::LinkPortals(TObjectPtr<APortal> NewTarget)
 		return;
 	}
 	
-	SetTickGroup(TG_PostUpdateWork);
 	this->LinkedPortal = NewTarget;
 }
 
@@ -793,111 +1229,250 @@ void APortal::SetCharacter(TObjectPtr<APortalRevisitedCharacter> NewCharacter)
 	Character = NewCharacter;
 }
 
-void APortal::RegisterOverlappingActor(TObjectPtr<AActor> Actor, TObjectPtr<UPrimitiveComponent> Component)
+void APortal::RegisterOverlappingActor(TObjectPtr<AActor> Actor)
 {
 	// Prevent to stack overflow by spawning clone actor.
 	if (bStopRegistering)
 		return;
 
+	PORTAL_SCOPE_CYCLE_COUNTER(RegisterOverlappingActor);
+	PORTAL_TRACE_SCOPE(Portal_RegisterOverlappingActor);
+
 	// Ignore cloned actors.
-	if(IgnoredActors.Contains(Actor))
+	if (IsClone(Actor))
 		return;
 
-	// Ignore overlapping actors already.
-	if (OverlappingActors.Contains(Actor))
+	// Ignore overlapping actors already. An actor coming back while
+	// its clone is retained keeps the clone.
+	const auto ExistingIndex = Tracked.FindOriginal(Actor);
+	if (ExistingIndex != INDEX_NONE)
+	{
+		if (EnumHasAnyFlags(Tracked.Flags[ExistingIndex], EPortalTrackedFlags::Leaving))
+		{
+			EnumRemoveFlags(Tracked.Flags[ExistingIndex], EPortalTrackedFlags::Leaving);
+			Tracked.TimesOutside[ExistingIndex] = 0.f;
+			++AvoidedCloneCycles;
+
+			UE_LOG(Portal, Verbose, TEXT("Clone retained: %s (avoided %d)"),
+				*Actor->GetName(), AvoidedCloneCycles);
+		}
 		return;
+	}
 	
-	Component->SetCollisionProfileName(TEXT(PORTAL_COLLISION_PROFILE_NAME));
-	OverlappingActors.AddUnique(Actor);
-	
-	auto SpawnParams = FActorSpawnParameters();
-	SpawnParams.Template = Actor;
+	// Decide how the actor is handled once, so per-frame work
+	// doesn't have to cast it again.
+	auto Kind = EPortalTrackedKind::Body;
+	TObjectPtr<USceneComponent> TrackedComponent = Actor->GetRootComponent();
+	auto Flags = EPortalTrackedFlags::None;
+
+	// The player passes the portal when the camera does, so the
+	// screen never shows the wall behind the portal.
+	if (const auto Player = Cast<APortalRevisitedCharacter>(Actor))
+	{
+		Kind = EPortalTrackedKind::Player;
+		TrackedComponent = Player->GetFirstPersonCameraComponent();
+	}
+
+	if (UPortalCharacterMovementComponent::HandlesPortalTraversal(*Actor))
+	{
+		Flags |= EPortalTrackedFlags::HandlesTraversal;
+	}
+
+	const auto PrimitiveCompOpt = GetPrimitiveComponent(Actor);
+
+	// Simulated bodies are passed by the physics thread in this mode.
+	const auto bIsSimulatedBody =
+		Kind == EPortalTrackedKind::Body &&
+		PrimitiveCompOpt &&
+		(*PrimitiveCompOpt)->IsSimulatingPhysics();
+
+	if (bPhysicsThreadTeleport && bIsSimulatedBody)
+	{
+		Flags |= EPortalTrackedFlags::HandlesTraversal;
+	}
+
+	// The collision profile of the actor is left as it is. The wall
+	// is passed inside the opening by the character movement, and by
+	// the portal contact modifier for simulated bodies.
+	const auto TrackedIndex = Tracked.Add(
+		Actor,
+		PrimitiveCompOpt ? *PrimitiveCompOpt : nullptr,
+		TrackedComponent,
+		Kind,
+		Flags);
 	
 	const auto ActorLocation = Actor->GetActorLocation();
 	const auto DestLocation = 
 		TransformPointToDestSpace(ActorLocation);
-	const auto LocationDifference =
-		DestLocation - ActorLocation;
+
+	// The player's clone is already built, so only wake it up.
+	if (Kind == EPortalTrackedKind::Player)
+	{
+		if (!PlayerClone)
+		{
+			UE_LOG(Portal, Warning, TEXT("The player clone isn't created."));
+			return;
+		}
+
+		PlayerClone->SetActorLocationAndRotation(
+			DestLocation,
+			TransformQuatToDestSpace(Actor->GetActorQuat()),
+			false,
+			nullptr,
+			ETeleportType::TeleportPhysics);
+
+		// Mark as the clone before enabling its collision,
+		// so the overlaps it begins are ignored.
+		Tracked.SetClone(TrackedIndex, PlayerClone);
+		SetPlayerCloneActive(true);
+		return;
+	}
 	
 	bStopRegistering = true;
 	LinkedPortal->bStopRegistering = true;
 
-	const auto Clone = DuplicateObject(Actor, Actor->GetOuter());
-	Clone->SetActorTransform(Actor->GetActorTransform());
-	Clone->RegisterAllComponents();
+	const auto Clone = [&Actor]()
+	{
+		PORTAL_TRACE_SCOPE(Portal_DuplicateObject);
+		return DuplicateObject(Actor, Actor->GetOuter());
+	}();
 
-	if (auto ClonePrimitiveCompOpt =
-		GetPrimitiveComponent(Clone))
+	if (!Clone)
 	{
-		(*ClonePrimitiveCompOpt)->
-			SetCollisionProfileName(TEXT(PORTAL_COLLISION_PROFILE_NAME));
+		bStopRegistering = false;
+		LinkedPortal->bStopRegistering = false;
+
+		UE_LOG(Portal, Warning, TEXT("Cloning failed: %s"), *Actor->GetName())
+		return;
 	}
 
-	auto OriginalPlayer = Cast<APortalRevisitedCharacter>(Actor);
-	auto ClonePlayer = Cast<APortalRevisitedCharacter>(Clone);
+	Clone->SetActorTransform(Actor->GetActorTransform());
+	Clone->RegisterAllComponents();
+	Clone->SetActorLocation(DestLocation);
+
+	MakeCloneKinematic(Clone);
+
+	Tracked.SetClone(TrackedIndex, Clone);
+	PORTAL_TRACE_BOOKMARK(TEXT("%s: clone %s of %s created"),
+		*GetName(), *Clone->GetName(), *Actor->GetName());
 	
-	if (OriginalPlayer && ClonePlayer)
+	bStopRegistering = false;
+	LinkedPortal->bStopRegistering = false;
+}
+
+void APortal::CreatePlayerClone()
+{
+	if (!Character)
 	{
-		ClonePlayer->GetMesh()->SetLeaderPoseComponent(OriginalPlayer->GetMesh());
-		ClonePlayer->GetMesh1P()->SetLeaderPoseComponent(OriginalPlayer->GetMesh1P());
+		UE_LOG(Portal, Error, TEXT("Cannot create the player clone: Character isn't set."));
+		return;
+	}
 
-		TArray<AActor*> AttachedActors;
-		OriginalPlayer->GetAttachedActors(AttachedActors);
+	if (!LinkedPortal)
+	{
+		UE_LOG(Portal, Error, TEXT("Cannot create the player clone: Portal isn't linked."));
+		return;
+	}
 
-		for (auto AttachedActor : AttachedActors)
-		{
-			const auto AttachedActorClone =
-				DuplicateObject(AttachedActor, AttachedActor->GetOuter());
-			AttachedActorClone->SetActorTransform(AttachedActor->GetActorTransform());
-			AttachedActorClone->RegisterAllComponents();
-
-			FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
-			AttachedActorClone->AttachToComponent(
-				ClonePlayer->GetMesh1P(),
-				AttachmentRules,
-				FName(TEXT("GripPoint")));
-
-			const auto SkinnedMeshComp = 
-				Cast<USkinnedMeshComponent>(AttachedActor);
-			const auto SkinnedMeshCompClone = 
-				Cast<USkinnedMeshComponent>(AttachedActorClone);
-			if (SkinnedMeshComp && SkinnedMeshCompClone)
-			{
-				SkinnedMeshCompClone->
-					SetLeaderPoseComponent(SkinnedMeshComp);
-			}
-		}
+	if (PlayerClone)
+	{
+		return;
 	}
+	
+	bStopRegistering = true;
+	LinkedPortal->bStopRegistering = true;
 
-	Clone->SetActorLocation(DestLocation);
+	PlayerClone = DuplicateObject(Character.Get(), Character->GetOuter());
 
-	if (!Clone)
+	if (!PlayerClone)
 	{
 		bStopRegistering = false;
 		LinkedPortal->bStopRegistering = false;
 
-		UE_LOG(Portal, Warning, TEXT("Cloning failed: %s"), *Actor->GetName())
+		UE_LOG(Portal, Warning, TEXT("Cloning failed: %s"), *Character->GetName())
 		return;
 	}
 
-	AddIgnoredActor(Clone);
-	LinkedPortal->AddIgnoredActor(Clone);
-	CloneMap.Add(Actor, Clone);
+	PlayerClone->SetActorTransform(Character->GetActorTransform());
+	PlayerClone->RegisterAllComponents();
+
+	PlayerClone->GetMesh()->SetLeaderPoseComponent(Character->GetMesh());
+	PlayerClone->GetMesh1P()->SetLeaderPoseComponent(Character->GetMesh1P());
+
+	TArray<AActor*> AttachedActors;
+	Character->GetAttachedActors(AttachedActors);
+
+	for (auto AttachedActor : AttachedActors)
+	{
+		const auto AttachedActorClone =
+			DuplicateObject(AttachedActor, AttachedActor->GetOuter());
+		AttachedActorClone->SetActorTransform(AttachedActor->GetActorTransform());
+		AttachedActorClone->RegisterAllComponents();
+
+		FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
+		AttachedActorClone->AttachToComponent(
+			PlayerClone->GetMesh1P(),
+			AttachmentRules,
+			FName(TEXT("GripPoint")));
+
+		const auto SkinnedMeshComp = 
+			Cast<USkinnedMeshComponent>(AttachedActor);
+		const auto SkinnedMeshCompClone = 
+			Cast<USkinnedMeshComponent>(AttachedActorClone);
+		if (SkinnedMeshComp && SkinnedMeshCompClone)
+		{
+			SkinnedMeshCompClone->
+				SetLeaderPoseComponent(SkinnedMeshComp);
+		}
+	}
+
+	// Sleep until the player approaches the portal.
+	SetPlayerCloneActive(false);
 	
 	bStopRegistering = false;
 	LinkedPortal->bStopRegistering = false;
 }
 
+void APortal::SetPlayerCloneActive(bool bActive)
+{
+	TArray<AActor*> CloneActors;
+	PlayerClone->GetAttachedActors(CloneActors);
+	CloneActors.Add(PlayerClone);
+
+	for (auto CloneActor : CloneActors)
+	{
+		CloneActor->SetActorHiddenInGame(!bActive);
+		CloneActor->SetActorEnableCollision(bActive);
+	}
+
+	PlayerClone->GetCharacterMovement()->SetComponentTickEnabled(bActive);
+}
+
 void APortal::Activate()
 {
+	PORTAL_TRACE_BOOKMARK(TEXT("Portal activated: %s"), *GetName());
+
 	bIsActivated = true;
 	SetMeshesVisibility(bIsActivated);
+
+	// Capture once, so the portal doesn't show an old image
+	// for the frame it first comes into view.
+	bWakeRequested = true;
+
+	// Actors already standing in front of the portal begin overlapping now.
+	PortalEnterMask->SetGenerateOverlapEvents(true);
+	PortalEnterMask->UpdateOverlaps();
 }
 
 void APortal::Deactivate()
 {
+	PORTAL_TRACE_BOOKMARK(TEXT("Portal deactivated: %s"), *GetName());
+
 	bIsActivated = false;
 	SetMeshesVisibility(bIsActivated);
+
+	// A closed portal takes no part in the overlap updates.
+	PortalEnterMask->SetGenerateOverlapEvents(false);
 }
 
 void APortal::SetMeshesVisibility(bool bNewVisibility)
@@ -928,35 +1503,40 @@ void APortal::OnOverlapBegin(
 
 	if (!OtherComp)
 		return;
+
+	// Passes the portal by its own movement, without any clone.
+	if (UPortalProjectileMovementComponent::HandlesPortalTraversal(*OtherActor))
+		return;
 	
-	if (GEngine)
-	{
-		UE_LOG(Portal, Log, TEXT("Overlap begin: OtherActor is %s"), *OtherActor->GetName());
-		UE_LOG(Portal, Log, TEXT("Overlap begin: OverlappedComp is %s"), *OverlappedComp->GetName());
-		UE_LOG(Portal, Log, TEXT("Overlap begin: OtherComp is %s"), *OtherComp->GetName());
-	}
+	UE_LOG(Portal, VeryVerbose, TEXT("Overlap begin: %s of %s overlaps %s"),
+		*OtherComp->GetName(),
+		*OtherActor->GetName(),
+		*OverlappedComp->GetName());
 
-	RegisterOverlappingActor(OtherActor, OtherComp);
+	RegisterOverlappingActor(OtherActor);
 }
 
-void APortal::UnregisterOverlappingActor(TObjectPtr<AActor> Actor, UPrimitiveComponent* Component)
+void APortal::UnregisterOverlappingActor(TObjectPtr<AActor> Actor)
 {
-	if(IgnoredActors.Contains(Actor))
+	const auto TrackedIndex = Tracked.FindOriginal(Actor);
+	if (TrackedIndex == INDEX_NONE)
 		return;
 
-	if (!OverlappingActors.Contains(Actor))
-		return;
+	RemoveClone(TrackedIndex);
+	Tracked.RemoveAtSwap(TrackedIndex);
+}
 
-	// If the actor overlapping to both portals, then set collision
-	// profile only one side of the portal.
-	if (!LinkedPortal->OverlappingActors.Contains(Actor))
+void APortal::ReleaseDestroyedActors()
+{
+	// Iterate backward, because releasing swaps the last entry in.
+	for (int32 i = Tracked.Num() - 1; i >= 0; --i)
 	{
-		Component->SetCollisionProfileName(TEXT(STANDARD_COLLISION_PROFILE_NAME));
-	}
-	
-	OverlappingActors.Remove(Actor);
+		if (IsValid(Tracked.Originals[i]) && IsValid(Tracked.TrackedComponents[i]))
+			continue;
 
-	RemoveClone(Actor);
+		RemoveClone(i);
+		Tracked.RemoveAtSwap(i);
+	}
 }
 
 void APortal::OnOverlapEnd(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp,
@@ -973,8 +1553,31 @@ void APortal::OnOverlapEnd(UPrimitiveComponent* OverlappedComp, AActor* OtherAct
 
 	if (!OtherComp)
 		return;
-	
-	UnregisterOverlappingActor(OtherActor, OtherComp);
+
+	// A fast actor can enter and leave the mask between two checks,
+	// so sweep it once more before forgetting it.
+	auto TrackedIndex = Tracked.FindOriginal(OtherActor);
+	if (TrackedIndex == INDEX_NONE)
+		return;
+
+	// A destroyed actor never leaves the mask, so its clone
+	// would never be released.
+	if (!IsValid(OtherActor) || OtherActor->IsActorBeingDestroyed())
+	{
+		UnregisterOverlappingActor(OtherActor);
+		return;
+	}
+
+	TeleportIfCrossed(TrackedIndex);
+
+	// The teleport may have released the actor already.
+	TrackedIndex = Tracked.FindOriginal(OtherActor);
+	if (TrackedIndex == INDEX_NONE)
+		return;
+
+	// Keep the clone until the actor goes far enough for long enough.
+	EnumAddFlags(Tracked.Flags[TrackedIndex], EPortalTrackedFlags::Leaving);
+	Tracked.TimesOutside[TrackedIndex] = 0.f;
 }
 
 FVector APortal::GetPortalUpVector() const
@@ -1172,13 +1775,42 @@ bool APortal::IsPointInFrontOfPortal(const FVector& Point, const FVector& Portal
 	return Result < EPSILON;
 }
 
+bool APortal::DoesSegmentCrossPortal(
+	const FVector& SegmentStart,
+	const FVector& SegmentEnd,
+	const FVector& PortalPos,
+	const FVector& PortalForward,
+	const FVector& PortalRight,
+	const FVector& PortalUp)
+{
+	const auto StartDistance =
+		FVector::DotProduct(SegmentStart - PortalPos, PortalForward);
+	const auto EndDistance =
+		FVector::DotProduct(SegmentEnd - PortalPos, PortalForward);
+
+	// Should move from the front side to the back side.
+	if (StartDistance <= 0.0 || EndDistance > 0.0)
+	{
+		return false;
+	}
+
+	const auto T = StartDistance / (StartDistance - EndDistance);
+	const auto CrossingPoint =
+		SegmentStart + (SegmentEnd - SegmentStart) * T;
+	const auto PortalToCrossing = CrossingPoint - PortalPos;
+
+	return
+		FMath::Abs(PortalToCrossing.Dot(PortalRight)) <= PORTAL_RIGHT_SIZE_HALF &&
+		FMath::Abs(PortalToCrossing.Dot(PortalUp)) <= PORTAL_UP_SIZE_HALF;
+}
+
 std::optional<TObjectPtr<APortal>> APortal::CastPortal(AActor* Actor)
 {
 	if(auto Casted = Cast<APortal>(Actor))
 	{
 		return Casted;
 	}
-	UE_LOG(Portal, Log, TEXT("Cast to Portal from %s: failed"), *Actor->GetClass()->GetName());
+	UE_LOG(Portal, VeryVerbose, TEXT("Cast to Portal from %s: failed"), *Actor->GetClass()->GetName());
 	return std::nullopt;
 }
 
@@ -6,10 +6,14 @@
 
 #include "CoreMinimal.h"
 #include "Engine/StaticMeshActor.h"
+#include "PortalLog.h"
+#include "PortalTrackedActors.h"
 #include "Portal.generated.h"
 
 #define PORTAL_COLLISION_PROFILE_NAME "Pawn_Hole"
-#define STANDARD_COLLISION_PROFILE_NAME "Pawn"
+
+constexpr auto PORTAL_UP_SIZE_HALF = 150.f;
+constexpr auto PORTAL_RIGHT_SIZE_HALF = 100.f;
 
 class APortalRevisitedCharacter;
 class UStaticMeshComponent;
@@ -18,8 +22,13 @@ class UArrowComponent;
 class UPortalGun;
 class UWallDissolver;
 class UPortalClipLocation;
+struct FPortalView;
+struct FPortalSnapshot;
+struct FPortalResult;
+struct FPortalPhysicsTeleportBody;
+class IPhysicsProxyBase;
 
-DECLARE_LOG_CATEGORY_EXTERN(Portal, Log, All);
+DECLARE_LOG_CATEGORY_EXTERN(Portal, Log, PORTAL_LOG_COMPILE_VERBOSITY);
 
 UCLASS()
 class PORTALREVISITED_API APortal : public AStaticMeshActor
@@ -39,6 +48,26 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	TObjectPtr<USoundBase> EnterSound;
 
+	/**
+	 * Seconds between traversal checks. Crossings are detected by sweeping
+	 * each tracked actor from its location at the previous check, so the
+	 * check doesn't need to run every frame. Zero checks every tick.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay, meta=(ClampMin="0.0"))
+	float TraversalCheckInterval;
+
+	/**
+	 * Distance beyond the enter mask an actor has to go before its
+	 * clone is released. Entering is decided by the mask itself, so an
+	 * actor jittering on the edge of the mask keeps its clone.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay, meta=(ClampMin="0.0"))
+	float CloneExitMargin;
+
+	/** Seconds an actor stays beyond the exit margin before its clone is released. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay, meta=(ClampMin="0.0"))
+	float CloneRetentionTime;
+
 	/**
 	 * 
 	 */
@@ -76,7 +105,7 @@ public:
 		int32 OtherBodyIndex,
 		bool bFromSweep,
 		const FHitResult& SweepResult);
-	void UnregisterOverlappingActor(TObjectPtr<AActor> Actor, UPrimitiveComponent* Component);
+	void UnregisterOverlappingActor(TObjectPtr<AActor> Actor);
 
 	UFUNCTION()
 	void OnOverlapEnd(
@@ -85,9 +114,28 @@ public:
 		UPrimitiveComponent* OtherComp,
 		int32 OtherBodyIndex);
 
+	/**
+	 * Forward a contact on a kinematic clone to the original,
+	 * as an impulse through the portal.
+	 * Only contacts with simulated bodies are reported. A kinematic
+	 * body makes no contact with static or other kinematic bodies, so
+	 * the original does not respond when its clone meets a wall on
+	 * the linked side.
+	 */
+	UFUNCTION()
+	void OnCloneHit(
+		UPrimitiveComponent* HitComponent,
+		AActor* OtherActor,
+		UPrimitiveComponent* OtherComp,
+		FVector NormalImpulse,
+		const FHitResult& Hit);
+
 	// Sets default values for this actor's properties
 	APortal();
 
+	/** Tracked actors are not properties, so they are reported here. */
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 	void LinkPortals(TObjectPtr<APortal> NewTarget);
 	void RegisterPortalGun(TObjectPtr<UPortalGun> NewPortalGun);
 	void SetPortalRenderTarget(TObjectPtr<UTextureRenderTarget2D> NewTexture);
@@ -96,15 +144,70 @@ public:
 	void SetPortalRecurRenderTarget(TObjectPtr<UTextureRenderTarget2D> NewTexture);
 	void SetPortalRecurMaterial(TObjectPtr<UMaterialInterface> NewMaterial);
 	void SetCharacter(TObjectPtr<APortalRevisitedCharacter> NewCharacter);
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-	void RegisterOverlappingActor(TObjectPtr<AActor> Actor, TObjectPtr<UPrimitiveComponent> Component);
+	/**
+	 * Build the clone of the character shown on the linked side.
+	 * It stays hidden and without collision until the character
+	 * approaches this portal.
+	 */
+	void CreatePlayerClone();
+
+	/**
+	 * Teleport an actor which will cross the portal in this frame's
+	 * physics, predicted from its velocity. Runs before physics, so the
+	 * actor is never drawn on the wrong side. The sweep in the commit
+	 * corrects what the prediction misses.
+	 * @return true if an actor was teleported.
+	 */
+	bool PredictTraversal(float DeltaTime);
+	/**
+	 * Per-frame phases, run once per pair by UPortalSubsystem.
+	 * The snapshot is made and committed on the game thread, and
+	 * computed in between on any thread.
+	 */
+	void MakeSnapshot(float DeltaTime, FPortalSnapshot& Snapshot);
+
+	/** Leave simulated bodies to be teleported on the physics thread. */
+	void SetPhysicsThreadTeleport(bool bNewPhysicsThreadTeleport);
+	void CollectPhysicsTeleportBodies(
+		bool bAtFirst,
+		TArray<FPortalPhysicsTeleportBody>& Bodies) const;
+	/** Finish passing a body the physics thread teleported. */
+	void HandleBodyPassed(const IPhysicsProxyBase* Proxy);
+	void CommitClones(const FPortalSnapshot& Snapshot, const FPortalResult& Result);
+	/** @return true if an actor was teleported. */
+	bool CommitTraversal(const FPortalSnapshot& Snapshot, const FPortalResult& Result);
+	/** Release the clones of actors which stayed out long enough. */
+	void UpdateLeavingActors(float DeltaTime);
+	/** @return true if the portal is seen and should be captured. */
+	bool CommitClipParameters(const FPortalView& View, const FPortalResult& Result);
+	void UpdateCapture(float DeltaTime, const FPortalView& View);
+	/**
+	 * @return false if the portal tracks no actor and no view has drawn
+	 * it recently. Such a portal sleeps until an actor overlaps it,
+	 * it is activated or it comes into view.
+	 */
+	bool HasWork() const;
+	bool IsSeen() const;
+
+	void RegisterOverlappingActor(TObjectPtr<AActor> Actor);
 	void Activate();
 	void Deactivate();
 	void SetMeshesVisibility(bool bNewVisibility);
 	
 	FVector GetPortalUpVector() const;
+
+	/**
+	 * @return the average frames from crossing the portal to the teleport.
+	 * Predicted teleports count as zero.
+	 */
+	float GetAverageTeleportLatencyFrames() const;
+
+	/** @return how many clone create and destroy cycles the retention avoided. */
+	int32 GetAvoidedCloneCycles() const;
+	/** @return how many actors are in front of the portal. */
+	int32 GetNumTracked() const;
+	/** @return the memory of the render targets the portal captures into. */
+	SIZE_T GetRenderTargetBytes() const;
 	FVector GetPortalRightVector() const;
 	FVector GetPortalForwardVector() const;
 	FVector GetPortalUpVector(const FQuat& PortalRotation) const;
@@ -113,9 +216,21 @@ public:
 	FVector GetPortalPlaneLocation() const;
 
 	TObjectPtr<APortal> GetLink() const;
+	bool IsActivated() const;
+
+	/** The wall component the portal is placed on. */
+	void SetHostSurface(TObjectPtr<UPrimitiveComponent> NewHostSurface);
+	TObjectPtr<UPrimitiveComponent> GetHostSurface() const;
+
+	/**
+	 * Called after the actor has been moved through this portal to
+	 * the linked portal, by the portal itself or by movement which
+	 * handles traversal on its own.
+	 */
+	void HandleActorPassed(TObjectPtr<AActor> Actor);
 	
-	void AddIgnoredActor(TObjectPtr<AActor> Actor);
-	void RemoveIgnoredActor(TObjectPtr<AActor> Actor);
+	/** @return true if the actor is a clone made by this or the linked portal. */
+	bool IsClone(const AActor* Actor) const;
 
 	std::optional<TObjectPtr<AActor>> GetOriginalIfClone(AActor* Actor);
 	
@@ -173,21 +288,38 @@ public:
 		const FVector& Point,
 		const FVector& PortalPos,
 		const FVector& PortalNormal);
+	/**
+	 * Check the segment passes through the bounded portal quad
+	 * from the front side to the back side.
+	 */
+	static bool DoesSegmentCrossPortal(
+		const FVector& SegmentStart,
+		const FVector& SegmentEnd,
+		const FVector& PortalPos,
+		const FVector& PortalForward,
+		const FVector& PortalRight,
+		const FVector& PortalUp);
 	
 	static std::optional<TObjectPtr<APortal>> CastPortal(AActor* Actor);
 
 private:
 	TObjectPtr<UBlueprint> CharacterBlueprint;
 	TObjectPtr<APortalRevisitedCharacter> Character;
+	TObjectPtr<APortalRevisitedCharacter> PlayerClone;
 
 	TObjectPtr<APortal> LinkedPortal;
+	TObjectPtr<UPrimitiveComponent> HostSurface;
 	uint8 PortalStencilValue;
 
 	bool bIsActivated;
+	bool bWakeRequested;
+	bool bPhysicsThreadTeleport;
 
-	TArray<TObjectPtr<AActor>> OverlappingActors;
-	TArray<TObjectPtr<AActor>> IgnoredActors;
-	TMap<TObjectPtr<AActor>, TObjectPtr<AActor>> CloneMap;
+	FPortalTrackedActors Tracked;
+	float TimeSinceTraversalCheck;
+	int32 AvoidedCloneCycles;
+	int32 NumTeleports;
+	uint64 TotalTeleportLatencyFrames;
 	bool bStopRegistering;
 	TObjectPtr<UPortalGun> PortalGun;
 
@@ -210,14 +342,27 @@ private:
 	void InitWallDissolver();
 	void InitAmbientSoundComponent();
 	
-	void UpdateClones();
 	LocationAndRotation CalculatePortalCameraLocationAndRotation(
 		const FVector& CameraLocation,
 		const FQuat& CameraQuat);
-	void UpdateCapture(float DeltaTime);
 	void CapturePortalSceneRecur(float DeltaTime, const FVector& CurrentCameraLocation, const FQuat& CurrentCameraRotation, int RecursionRemaining);
-	void CheckAndTeleportOverlappingActors();
+	void TeleportTracked(int32 TrackedIndex, uint64 LatencyFrames);
+	bool IsSnapshotEntryValid(const FPortalSnapshot& Snapshot, int32 TrackedIndex) const;
+	float GetDistanceOutsideEnterMask(const FVector& Location) const;
+	bool TeleportIfCrossed(int32 TrackedIndex);
+	void ResetTrackedLocation(TObjectPtr<AActor> Actor);
 	void PlaySoundAtLocation(USoundBase* SoundToPlay, FVector Location);
-	void TeleportActor(AActor& Actor);
-	void RemoveClone(TObjectPtr<AActor> Actor);
+	void TeleportActor(
+		AActor& Actor,
+		EPortalTrackedKind Kind,
+		UPrimitiveComponent* PrimitiveComponent);
+	void RemoveClone(int32 TrackedIndex);
+	/** Release the entries of actors destroyed while tracked, and their clones. */
+	void ReleaseDestroyedActors();
+	/**
+	 * The clone follows the original as a kinematic body, so only
+	 * the original is simulated.
+	 */
+	void MakeCloneKinematic(TObjectPtr<AActor> Clone);
+	void SetPlayerCloneActive(bool bActive);
 };
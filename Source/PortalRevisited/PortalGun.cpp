@@ -11,6 +11,10 @@
 
 #include "Portal.h"
 #include "PortalRevisitedCharacter.h"
+#include "PortalCharacterMovementComponent.h"
+#include "PortalContactModifier.h"
+#include "PortalGrabController.h"
+#include "PortalSubsystem.h"
 #include "PortalRevisitedProjectile.h"
 #include "PortalUtil.h"
 #include "GameFramework/PlayerController.h"
@@ -21,20 +25,32 @@
 #include "Camera/CameraComponent.h"
 #include "Components/ArrowComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "Engine/StaticMeshActor.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Misc/ScopeExit.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "PhysicsEngine/PhysicsHandleComponent.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
 
 constexpr float PORTAL_GUN_RANGE = 5000.f;
 constexpr float PORTAL_GUN_GRAB_RANGE = 400.f;
 constexpr float PORTAL_GUN_GRAB_OFFSET = 200.f;
 constexpr float PORTAL_GUN_GRAB_FORCE_MULTIPLIER = 5.f;
-constexpr auto PORTAL_UP_SIZE_HALF = 150.f;
-constexpr auto PORTAL_RIGHT_SIZE_HALF = 100.f;
-constexpr auto WHITE_SURFACE = EPhysicalSurface::SurfaceType1;
+constexpr int32 PORTAL_PLANE_POOL_SIZE = 4;
+// How close the plane query may pass by a portal rectangle
+// and still be regarded as reaching it.
+constexpr double PORTAL_PLANE_QUERY_MARGIN = 50.0;
+constexpr float PORTAL_GUN_DEFAULT_PROJECTILE_SPEED = 3000.f;
+// The placement preview is traced again only
+// when the aim moves further than these.
+constexpr float PORTAL_GUN_PREVIEW_LOCATION_TOLERANCE = 1.f;
+constexpr float PORTAL_GUN_PREVIEW_ANGLE_TOLERANCE = 0.5f;
+// The preview places portals every frame, so its logs are rate limited.
+constexpr double PORTAL_GUN_LOG_INTERVAL = 1.0;
 
 // OverlapAllDynamic Preset blocks ECC_GameTraceChannel3,
 // so it can uses also to query if there is a portal or not.
@@ -44,6 +60,13 @@ constexpr auto PORTAL_QUERY =
 UPortalGun::UPortalGun()
 	: USkeletalMeshComponent()
 	, MuzzleOffset(100.0f, 0.0f, 10.0f)
+	, bInstancedProjectiles(false)
+	, ProjectileMeshScale(0.1f)
+	, bPhysicsThreadTeleport(false)
+	, bPlacementPreview(false)
+	, PortalContactModifier(nullptr)
+	, PortalGrabController(nullptr)
+	, GrabId(0)
 {
 	using Asset = ConstructorHelpers::FObjectFinder<UStaticMesh>;
 	Asset PlaneMeshAsset(
@@ -179,6 +202,8 @@ UPortalGun::UPortalGun()
 
 	PrimaryComponentTick.bCanEverTick = true;
 	SetTickGroup(TG_PrePhysics);
+
+	PlacementPreviewTraceDelegate.BindUObject(this, &UPortalGun::OnPlacementPreviewTraced);
 }
 
 void UPortalGun::LinkPortals()
@@ -192,6 +217,13 @@ void UPortalGun::LinkPortals()
 	BluePortal->RegisterPortalGun(this);
 	OrangePortal->RegisterPortalGun(this);
 
+	if (const auto Movement =
+		Cast<UPortalCharacterMovementComponent>(Character->GetCharacterMovement()))
+	{
+		Movement->RegisterPortal(BluePortal);
+		Movement->RegisterPortal(OrangePortal);
+	}
+
 	BluePortal->SetPortalRenderTarget(BluePortalRenderTarget);
 	OrangePortal->SetPortalRenderTarget(OrangePortalRenderTarget);
 	
@@ -207,14 +239,203 @@ void UPortalGun::LinkPortals()
 	BluePortal->SetPortalRecurMaterial(BluePortalRecurMaterial);
 	OrangePortal->SetPortalRecurMaterial(OrangePortalRecurMaterial);
 
-	PrimaryComponentTick.AddPrerequisite(this, BluePortal->PrimaryActorTick);
-	PrimaryComponentTick.AddPrerequisite(this, OrangePortal->PrimaryActorTick);	
+	if (const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>())
+	{
+		PortalSubsystem->RegisterPair(
+			BluePortal,
+			OrangePortal,
+			bPhysicsThreadTeleport);
+	}
 
 	BluePortal->WallDissolver->SetDissolverName("Blue");
 	OrangePortal->WallDissolver->SetDissolverName("Orange");
 
 	BluePortal->Deactivate();
 	OrangePortal->Deactivate();
+
+	BluePortal->CreatePlayerClone();
+	OrangePortal->CreatePlayerClone();
+
+	CreatePlanePool(BluePortalPlanes);
+	CreatePlanePool(OrangePortalPlanes);
+	CreateProjectilePool();
+
+	RegisterPortalContactModifier();
+	RegisterPortalGrabController();
+}
+
+void UPortalGun::RegisterPortalContactModifier()
+{
+	if (PortalContactModifier)
+	{
+		return;
+	}
+
+	const auto PhysicsScene = GetWorld()->GetPhysicsScene();
+	if (!PhysicsScene)
+	{
+		UE_LOG(Portal, Warning, TEXT("Cannot find the physics scene. Bodies cannot pass the portal wall."));
+		return;
+	}
+
+	PortalContactModifier =
+		PhysicsScene->GetSolver()->
+			CreateAndRegisterSimCallbackObject_External<FPortalContactModifier>();
+}
+
+void UPortalGun::UnregisterPortalContactModifier()
+{
+	if (!PortalContactModifier)
+	{
+		return;
+	}
+
+	if (const auto PhysicsScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsScene->GetSolver()->
+			UnregisterAndFreeSimCallbackObject_External(PortalContactModifier);
+	}
+
+	PortalContactModifier = nullptr;
+}
+
+void UPortalGun::UpdatePortalContactModifier()
+{
+	if (!PortalContactModifier)
+	{
+		return;
+	}
+
+	auto Input = PortalContactModifier->GetProducerInputData_External();
+	Input->Openings.Reset();
+
+	// The wall can be passed only if the portal leads somewhere.
+	const auto bArePortalsActivated =
+		BluePortal->IsActivated() && OrangePortal->IsActivated();
+
+	if (!bArePortalsActivated)
+	{
+		return;
+	}
+
+	for (const auto& Portal : { BluePortal, OrangePortal })
+	{
+		if (const auto Opening = FPortalOpening::Make(*Portal))
+		{
+			Input->Openings.Add(*Opening);
+		}
+	}
+}
+
+void UPortalGun::RegisterPortalGrabController()
+{
+	if (PortalGrabController)
+	{
+		return;
+	}
+
+	const auto PhysicsScene = GetWorld()->GetPhysicsScene();
+	if (!PhysicsScene)
+	{
+		UE_LOG(Portal, Warning, TEXT("Cannot find the physics scene. Objects cannot be grabbed."));
+		return;
+	}
+
+	PortalGrabController =
+		PhysicsScene->GetSolver()->
+			CreateAndRegisterSimCallbackObject_External<FPortalGrabController>();
+}
+
+void UPortalGun::UnregisterPortalGrabController()
+{
+	if (!PortalGrabController)
+	{
+		return;
+	}
+
+	if (const auto PhysicsScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsScene->GetSolver()->
+			UnregisterAndFreeSimCallbackObject_External(PortalGrabController);
+	}
+
+	PortalGrabController = nullptr;
+}
+
+void UPortalGun::UpdatePortalGrabController()
+{
+	if (!PortalGrabController)
+	{
+		return;
+	}
+
+	// The physics thread let the object go, because it was too far
+	// or the portal it was held through went out of view.
+	while (const auto Output = PortalGrabController->PopOutputData_External())
+	{
+		if (bIsGrabbing && Output->CanceledGrabId == GrabId)
+		{
+			UE_LOG(Portal, Log, TEXT("Cannot hold the grabbed object: Cancel grab."));
+			StopGrabbing();
+		}
+	}
+
+	auto Input = PortalGrabController->GetProducerInputData_External();
+	Input->Reset();
+
+	if (!bIsGrabbing)
+	{
+		return;
+	}
+
+	const auto PrimitiveCompOpt = GetPrimitiveComponent(GrabbedActor);
+	if (!PrimitiveCompOpt)
+	{
+		return;
+	}
+
+	const auto BodyInstance = (*PrimitiveCompOpt)->GetBodyInstance();
+	if (!BodyInstance || !BodyInstance->ActorHandle)
+	{
+		return;
+	}
+
+	const auto CameraComponent = Character->GetFirstPersonCameraComponent();
+	const auto CameraLocation =
+		CameraComponent->GetComponentLocation();
+	const auto CameraDirection =
+		CameraComponent->GetForwardVector();
+
+	Input->Proxy = BodyInstance->ActorHandle;
+	Input->GrabId = GrabId;
+	Input->bAcrossedPortal = bIsGrabbedObjectAcrossedPortal;
+	Input->ViewStart = CameraLocation;
+	Input->ViewEnd = CameraLocation + CameraDirection * PORTAL_GUN_GRAB_RANGE;
+	Input->TargetLocation = CameraLocation + CameraDirection * PORTAL_GUN_GRAB_OFFSET;
+	Input->MaxDistance = PORTAL_GUN_GRAB_OFFSET * 2.0f;
+	Input->VelocityMultiplier = PORTAL_GUN_GRAB_FORCE_MULTIPLIER;
+
+	// The object can be held through the portal only if it leads somewhere.
+	if (BluePortal->IsActivated() && OrangePortal->IsActivated())
+	{
+		Input->bHasPortals = true;
+		Input->First = FPortalFrame::Make(*BluePortal);
+		Input->Second = FPortalFrame::Make(*OrangePortal);
+	}
+}
+
+void UPortalGun::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ProjectilePool.Destroy();
+	UnregisterPortalContactModifier();
+	UnregisterPortalGrabController();
+
+	if (const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>())
+	{
+		PortalSubsystem->UnregisterPair(BluePortal);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UPortalGun::AttachPortalGun(APortalRevisitedCharacter* TargetCharacter)
@@ -236,7 +457,6 @@ void UPortalGun::AttachPortalGun(APortalRevisitedCharacter* TargetCharacter)
 		UE_LOG(Portal, Error, TEXT("Cannot find portal textures.(RT_BluePortal, RT_OrangePortal)"))
 		return;
 	}
-	LinkPortals();
 
 	// Attach the weapon to the First Person Character
 	FAttachmentTransformRules AttachmentRules(EAttachmentRule::SnapToTarget, true);
@@ -245,6 +465,10 @@ void UPortalGun::AttachPortalGun(APortalRevisitedCharacter* TargetCharacter)
 	// switch bHasPortalGun so the animation blueprint can switch to another animation set
 	Character->SetHasPortalGun(true);
 
+	// Link after attaching, so the player clones are built
+	// holding the portal gun.
+	LinkPortals();
+
 	// Set up action bindings
 	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
 	{
@@ -295,7 +519,7 @@ void UPortalGun::PlayFiringAnimation()
 
 void UPortalGun::FireBlue()
 {
-	UE_LOG(Portal, Log, TEXT("Fire blue portal"));
+	UE_LOG(Portal, Verbose, TEXT("Fire blue portal"));
 
 	if (!BluePortal)
 	{
@@ -309,7 +533,7 @@ void UPortalGun::FireBlue()
 
 void UPortalGun::FireOrange()
 {
-	UE_LOG(Portal, Log, TEXT("Fire orange portal"));
+	UE_LOG(Portal, Verbose, TEXT("Fire orange portal"));
 
 	if (!OrangePortal)
 	{
@@ -323,46 +547,32 @@ void UPortalGun::FireOrange()
 
 void UPortalGun::FirePortal(TObjectPtr<APortal> TargetPortal)
 {
-	auto Camera = Character->GetFirstPersonCameraComponent();
-
-	auto Start = Camera->GetComponentLocation();
-	auto Direction = Camera->GetForwardVector();
-	auto End = Start + Direction * PORTAL_GUN_RANGE;
-
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(Character);
-	CollisionParams.AddIgnoredActor(TargetPortal);
-	CollisionParams.bReturnPhysicalMaterial = true;
-	
-	TArray<FHitResult> HitResults;
+	const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>();
+	if (!PortalSubsystem)
+	{
+		return;
+	}
 
-	bool bIsBlocked = GetWorld()->LineTraceMultiByChannel(
-		HitResults,
-		Start,
-		End,
-		ECC_WorldStatic,
-		CollisionParams);
+	const auto Result = PortalSubsystem->Raycast(MakeFireRaycastQuery(TargetPortal));
 
-	bool bIsHitNothing = HitResults.IsEmpty();
-	
-	if (bIsHitNothing)
+	if (Result.StoppedPortal)
 	{
-		UE_LOG(Portal, Log, TEXT("Fired portal but hit nothing."));
+		UE_LOG(Portal, Verbose, TEXT("Fired portal but hit linked portal."))
+		FirePortalProjectile(Result.StoppedLocation, false);
 		return;
 	}
-	
-	auto HitResult = HitResults[0];
-	
-	if (HitResult.GetActor()->GetUniqueID() == TargetPortal->GetLink()->GetUniqueID())
+
+	if (!Result.Hit)
 	{
-		UE_LOG(Portal, Log, TEXT("Fired portal but hit linked portal."))
-		FirePortalProjectile(HitResult.ImpactPoint, false);
+		UE_LOG(Portal, Verbose, TEXT("Fired portal but hit nothing."));
 		return;
 	}
 
+	const auto& HitResult = *Result.Hit;
+
 	if (!CanPlacePortal(HitResult.PhysMaterial.Get()))
 	{
-		UE_LOG(Portal, Log, TEXT("Hit non-white wall."))
+		UE_LOG(Portal, Verbose, TEXT("Hit non-white wall."))
 		FirePortalProjectile(HitResult.ImpactPoint, false);
 		return;
 	}
@@ -374,15 +584,27 @@ void UPortalGun::FirePortal(TObjectPtr<APortal> TargetPortal)
 	if (!PortalPoint)
 	{
 		// Portal cannot be created.
-		UE_LOG(Portal, Log, TEXT("Cannot place the portal"));
+		UE_LOG(Portal, Verbose, TEXT("Cannot place the portal"));
 		return;
 	}
 
+	const auto OldPortalLocation = TargetPortal->GetActorLocation();
+	const auto OldPortalQuat = TargetPortal->GetActorQuat();
+
 	TargetPortal->SetActorLocation(PortalPoint->first);
 	TargetPortal->SetActorRotation(PortalPoint->second);
+	TargetPortal->SetHostSurface(HitResult.GetComponent());
 
-	SpawnPlanesAroundPortal(BluePortal);
-	SpawnPlanesAroundPortal(OrangePortal);
+	UpdatePlanesAroundPortal(TargetPortal);
+
+	// Planes of the other portal only change when the moved portal
+	// was, or now is, on the ground in front of it.
+	const auto OtherPortal = TargetPortal->GetLink();
+	if (IsInPlaneQueryRange(*OtherPortal, OldPortalLocation, OldPortalQuat) ||
+		IsInPlaneQueryRange(*OtherPortal, PortalPoint->first, PortalPoint->second))
+	{
+		UpdatePlanesAroundPortal(OtherPortal);
+	}
 
 	if (TargetPortal->WallDissolver->GetDissolverName().IsEmpty())
 	{
@@ -391,38 +613,79 @@ void UPortalGun::FirePortal(TObjectPtr<APortal> TargetPortal)
 	TargetPortal->WallDissolver->UpdateParameters(TargetPortal->GetActorLocation());
 
 	TargetPortal->Activate();
+	UpdatePortalContactModifier();
+	PortalSubsystem->InvalidateRaycasts();
+	InvalidatePlacementPreviews();
+}
+
+FPortalRaycastQuery UPortalGun::MakeCameraRaycastQuery(
+	double Range,
+	ECollisionChannel Channel) const
+{
+	const auto Camera = Character->GetFirstPersonCameraComponent();
+
+	FPortalRaycastQuery Query;
+	Query.Start = Camera->GetComponentLocation();
+	Query.Direction = Camera->GetForwardVector();
+	Query.Range = Range;
+	Query.Channel = Channel;
+	Query.IgnoredActors.Add(Character);
+
+	return Query;
+}
+
+FPortalRaycastQuery UPortalGun::MakeFireRaycastQuery(TObjectPtr<APortal> TargetPortal) const
+{
+	auto Query = MakeCameraRaycastQuery(PORTAL_GUN_RANGE, ECC_WorldStatic);
+	// The portal can be placed again on the wall it is on.
+	Query.IgnoredActors.Add(TargetPortal);
+	Query.MaxHops = 0;
+	Query.bReturnPhysicalMaterial = true;
+
+	return Query;
 }
 
 void UPortalGun::FirePortalProjectile(const FVector& ImpactPoint, bool CanCreatePortal)
 {
-	if (!ProjectileClass)
-	{
-		UE_LOG(Portal, Warning, TEXT("FirePortalProjectile: Projectile class doesn't set. The projectile will be not spawn."));
-		return;
-	}
+	UE_LOG(Portal, Verbose, TEXT("FirePortalProjectile: Fire a pooled projectile."))
+		
+	auto* PlayerController = Cast<APlayerController>(Character->GetController());
+	const auto SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+	// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+	const auto SpawnLocation = Character->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
 
+	// Fire the projectile from the muzzle
+	ProjectilePool.Fire(SpawnLocation, SpawnRotation, ImpactPoint);
+}
+
+void UPortalGun::CreateProjectilePool()
+{
 	const auto World = GetWorld();
 	if(!World)
 	{
-		UE_LOG(Portal, Error, TEXT("FirePortalProjectile: Cannot get the world."));
+		UE_LOG(Portal, Error, TEXT("CreateProjectilePool: Cannot get the world."));
 		return;
 	}
 
-	UE_LOG(Portal, Log, TEXT("FirePortalProjectile: Spawn a projectile."))
-		
-	auto* PlayerController = Cast<APlayerController>(Character->GetController());
-	const auto SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
-	// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
-	const auto SpawnLocation = Character->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
+	if (bInstancedProjectiles && ProjectileMesh)
+	{
+		// Move as fast as the projectile actor would.
+		const auto Speed = ProjectileClass ?
+			ProjectileClass->GetDefaultObject<APortalRevisitedProjectile>()->
+				GetProjectileMovement()->InitialSpeed :
+			PORTAL_GUN_DEFAULT_PROJECTILE_SPEED;
 
-	//Set Spawn Collision Handling Override
-	FActorSpawnParameters ActorSpawnParams;
-	ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		ProjectilePool.CreateInstances(*GetOwner(), ProjectileMesh, ProjectileMeshScale, Speed);
+		return;
+	}
 
-	// Spawn the projectile at the muzzle
-	auto Spawned = World->SpawnActor<APortalRevisitedProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
-	Spawned->SetPrjectileDestination(ImpactPoint);
-	
+	if (!ProjectileClass)
+	{
+		UE_LOG(Portal, Warning, TEXT("CreateProjectilePool: Projectile class doesn't set. The projectile will be not spawn."));
+		return;
+	}
+
+	ProjectilePool.CreateActors(*World, ProjectileClass);
 }
 
 bool UPortalGun:: CanPlacePortal(UPhysicalMaterial* WallPhysicalMaterial)
@@ -430,13 +693,60 @@ bool UPortalGun:: CanPlacePortal(UPhysicalMaterial* WallPhysicalMaterial)
 	return WallPhysicalMaterial->SurfaceType == WHITE_SURFACE;
 }
 
-void UPortalGun::SpawnPlanesAroundPortal(TObjectPtr<APortal> TargetPortal)
+void UPortalGun::CreatePlanePool(TArray<TObjectPtr<AStaticMeshActor>>& TargetCollisionPlanes)
+{
+	UWorld* const World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	FActorSpawnParameters ActorSpawnParams;
+	ActorSpawnParams.SpawnCollisionHandlingOverride =
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	while (TargetCollisionPlanes.Num() < PORTAL_PLANE_POOL_SIZE)
+	{
+		auto SpawnedPlane = World->SpawnActor<AStaticMeshActor>(
+			FVector::ZeroVector,
+			FRotator::ZeroRotator,
+			ActorSpawnParams);
+
+		if (!SpawnedPlane)
+		{
+			return;
+		}
+
+		// Planes are re-posed when the portal moves, so they should
+		// be movable.
+		SpawnedPlane->SetActorHiddenInGame(true);
+		SpawnedPlane->SetActorScale3D(FVector(1.0, 2.0, 1.0));
+		SpawnedPlane->SetMobility(EComponentMobility::Movable);
+		SpawnedPlane->GetStaticMeshComponent()->SetStaticMesh(PlaneMesh);
+		auto PrimitiveComp =
+			Cast<UPrimitiveComponent>(SpawnedPlane->GetRootComponent());
+		PrimitiveComp->SetCollisionProfileName(PORTAL_COLLISION_PROFILE_NAME);
+		SpawnedPlane->SetActorEnableCollision(false);
+
+		TargetCollisionPlanes.Add(SpawnedPlane);
+	}
+}
+
+void UPortalGun::UpdatePlanesAroundPortal(TObjectPtr<APortal> TargetPortal)
 {
-	UE_LOG(Portal, Log, TEXT("Spawn planes in front of the portal."))
+	UE_LOG(Portal, Verbose, TEXT("Update planes in front of the portal."))
 
 	auto& CollisionPlanes = GetCollisionPlanes(TargetPortal);
+	int32 UsedPlaneCount = 0;
 
-	DestroyAllPlanesSpawnedBefore(CollisionPlanes);
+	// Planes not re-posed in this update are put away.
+	ON_SCOPE_EXIT
+	{
+		for (int32 i = UsedPlaneCount; i < CollisionPlanes.Num(); ++i)
+		{
+			CollisionPlanes[i]->SetActorEnableCollision(false);
+		}
+	};
 
 	UWorld* const World = GetWorld();
 	if (!World)
@@ -456,6 +766,12 @@ void UPortalGun::SpawnPlanesAroundPortal(TObjectPtr<APortal> TargetPortal)
 	CollisionParams.AddIgnoredActor(Character);
 	CollisionParams.AddIgnoredActor(TargetPortal);
 
+	// Do not hit the planes of this portal placed before.
+	for (const auto& Plane : CollisionPlanes)
+	{
+		CollisionParams.AddIgnoredActor(Plane);
+	}
+
 	TArray<FHitResult> HitResults;
 
 	const auto Start = PortalFront;
@@ -473,7 +789,7 @@ void UPortalGun::SpawnPlanesAroundPortal(TObjectPtr<APortal> TargetPortal)
 
 	if (bIsHitNothing)
 	{
-		UE_LOG(Portal, Log, TEXT("There is no ground in front of the portal."))
+		UE_LOG(Portal, Verbose, TEXT("There is no ground in front of the portal."))
 		return;
 	}
 
@@ -483,59 +799,82 @@ void UPortalGun::SpawnPlanesAroundPortal(TObjectPtr<APortal> TargetPortal)
 		const auto Actor = HitResult.GetActor();
 		if (APortal::CastPortal(Actor))
 		{
-			UE_LOG(Portal, Log, TEXT("There is a portal in front of the portal."))
+			UE_LOG(Portal, Verbose, TEXT("There is a portal in front of the portal."))
 			return;
 		}
 	}
 
-	UE_LOG(Portal, Log, TEXT("Found %d actors in front of the protal"), HitResults.Num())
+	UE_LOG(Portal, Verbose, TEXT("Found %d actors in front of the protal"), HitResults.Num())
 	for (auto HitResult : HitResults)
 	{
 		// If the actor is movable, it is may a cube, so continue.
 		if (HitResult.GetActor()->IsRootComponentMovable())
 		{
-			UE_LOG(Portal, Log, TEXT("Found a movable actor in front of the portal, but ignore it."));
+			UE_LOG(Portal, Verbose, TEXT("Found a movable actor in front of the portal, but ignore it."));
 			continue;
 		}
-		UE_LOG(Portal, Log, TEXT("Found a static actor in front of the portal, try spawn a plane"));
 
-		const auto SpawnLocation = HitResult.ImpactPoint;
+		if (UsedPlaneCount >= CollisionPlanes.Num())
+		{
+			UE_LOG(Portal, Warning, TEXT("No more plane in the pool, ignore the rest of the ground."));
+			return;
+		}
+		UE_LOG(Portal, Verbose, TEXT("Found a static actor in front of the portal, try place a plane"));
+
+		const auto PlaneLocation = HitResult.ImpactPoint;
 		const auto PlaneNormal = HitResult.ImpactNormal;
 		const auto PlaneV =
 			PortalForward.Cross(PlaneNormal);
 		const auto PlaneU = 
 			PlaneNormal.Cross(PlaneV).GetSafeNormal();
-		const auto SpawnRotation =
+		const auto PlaneRotation =
 			UKismetMathLibrary::MakeRotationFromAxes(
 				PlaneU,
 				PlaneV,
 				PlaneNormal);
 
-		FActorSpawnParameters ActorSpawnParams;
-		ActorSpawnParams.SpawnCollisionHandlingOverride =
-			ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		const auto Plane = CollisionPlanes[UsedPlaneCount++];
+		Plane->SetActorLocationAndRotation(
+			PlaneLocation,
+			PlaneRotation,
+			false,
+			nullptr,
+			ETeleportType::TeleportPhysics);
+		Plane->SetActorEnableCollision(true);
 
-		auto SpawnedPlane = World->SpawnActor<AStaticMeshActor>(
-			SpawnLocation,
-			SpawnRotation,
-			ActorSpawnParams);
+		UE_LOG(Portal, Verbose, TEXT("The plane placed on the ground."))
+	}
+}
 
-		if (!SpawnedPlane)
-		{
-			return;
-		}
-		SpawnedPlane->SetActorHiddenInGame(true);
-		SpawnedPlane->SetActorScale3D(FVector(1.0, 2.0, 1.0));
-		SpawnedPlane->SetMobility(EComponentMobility::Stationary);
-		SpawnedPlane->GetStaticMeshComponent()->SetStaticMesh(PlaneMesh);
-		auto PrimitiveComp =
-			Cast<UPrimitiveComponent>(SpawnedPlane->GetRootComponent());
-		PrimitiveComp->SetCollisionProfileName(PORTAL_COLLISION_PROFILE_NAME);
+bool UPortalGun::IsInPlaneQueryRange(
+	const APortal& TargetPortal,
+	const FVector& PortalLocation,
+	const FQuat& PortalQuat) const
+{
+	const auto PortalFront =
+		TargetPortal.GetActorLocation() +
+		TargetPortal.GetActorForwardVector() * 50.0f;
+	const auto PortalDown = -TargetPortal.GetActorUpVector();
 
-		CollisionPlanes.Add(SpawnedPlane);
+	// Test the query segment against the whole portal rectangle, in
+	// the space of the portal, so a corner reaching it counts too.
+	const FTransform PortalTransform(PortalQuat, PortalLocation);
+	const auto Start =
+		PortalTransform.InverseTransformPositionNoScale(PortalFront);
+	const auto End =
+		PortalTransform.InverseTransformPositionNoScale(
+			PortalFront + PortalDown * PORTAL_UP_SIZE_HALF * 2.0);
 
-		UE_LOG(Portal, Log, TEXT("The plane spawned on the ground."))
-	}
+	const auto Extent = FVector(
+		PORTAL_PLANE_QUERY_MARGIN,
+		PORTAL_RIGHT_SIZE_HALF + PORTAL_PLANE_QUERY_MARGIN,
+		PORTAL_UP_SIZE_HALF + PORTAL_PLANE_QUERY_MARGIN);
+
+	return FMath::LineBoxIntersection(
+		FBox(-Extent, Extent),
+		Start,
+		End,
+		End - Start);
 }
 
 TArray<TObjectPtr<AStaticMeshActor>>& UPortalGun::GetCollisionPlanes(TObjectPtr<APortal> TargetPortal)
@@ -547,308 +886,223 @@ TArray<TObjectPtr<AStaticMeshActor>>& UPortalGun::GetCollisionPlanes(TObjectPtr<
 	return OrangePortalPlanes;
 }
 
-void UPortalGun::DestroyAllPlanesSpawnedBefore(TArray<TObjectPtr<AStaticMeshActor>>& TargetCollisionPlanes)
+
+UPortalGun::PortalCenterAndNormal UPortalGun::CalculateCorrectPortalCenter(
+	const FHitResult& HitResult,
+	const APortal& TargetPortal) const
 {
-	if (!TargetCollisionPlanes.IsEmpty())
-	{
-		for (auto Plane : TargetCollisionPlanes)
-		{
-			Plane->Destroy();
-		}
+	const auto Placement = FPortalPlacementSolver::Solve(
+		MakePlacementInput(HitResult, TargetPortal));
 
-		TargetCollisionPlanes.Empty();
+	if (!Placement)
+	{
+		return std::nullopt;
 	}
-}
 
+	return std::make_pair(Placement->Location, Placement->Rotation);
+}
 
-UPortalGun::PortalCenterAndNormal UPortalGun::CalculateCorrectPortalCenter(
+FPortalPlacementInput UPortalGun::MakePlacementInput(
 	const FHitResult& HitResult,
 	const APortal& TargetPortal) const
 {
-	constexpr auto PortalForwardOffset = 3.0f;
-	FVector ResultPoint = HitResult.ImpactPoint -
-		PortalForwardOffset * HitResult.ImpactNormal;
-
-	const auto PortalRotation =
-		CalculatePortalRotation(HitResult.ImpactNormal, TargetPortal);
+	FPortalPlacementInput Input;
+	Input.ImpactPoint = HitResult.ImpactPoint;
+	Input.ImpactNormal = HitResult.ImpactNormal;
+	Input.PortalQuat = TargetPortal.GetActorQuat();
+	Input.CharacterForward = Character->GetActorForwardVector();
+
+	// The baked surface has exact bounds, even of rotated walls.
+	if (const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>())
+	{
+		const auto& SurfaceIndex = PortalSubsystem->GetSurfaceIndex();
+		if (const auto Surface = SurfaceIndex.FindSurface(
+			HitResult.ImpactPoint,
+			HitResult.ImpactNormal))
+		{
+			Input.SurfaceRect = *Surface;
+			return Input;
+		}
 
-	const auto PortalUp = TargetPortal.GetPortalUpVector(PortalRotation);
-	const auto PortalRight = TargetPortal.GetPortalRightVector(PortalRotation);
+		// A missing index is logged once at load.
+		if (SurfaceIndex.IsLoaded())
+		{
+			PORTAL_LOG_RATE_LIMITED(
+				Portal,
+				Log,
+				PORTAL_GUN_LOG_INTERVAL,
+				TEXT("%s is not in the portal surface index. The portal is placed within its bounds."),
+				*GetNameSafe(HitResult.GetActor()));
+		}
+	}
 
 	const auto OtherActorBounds =
 		HitResult.GetActor()->GetComponentsBoundingBox();
 
-	const auto Center = OtherActorBounds.GetCenter();
-	const auto Extent = OtherActorBounds.GetExtent();
-
-	{
-		// Calculate offset to X axis.
-		const auto PortalOffsetX = MovePortalUAxisAligned(
-			Center,
-			Extent,
-			PortalRight,
-			PortalUp,
-			ResultPoint,
-			FVector(1.0, 0.0, 0.0)
-		);
+	Input.SurfaceCenter = OtherActorBounds.GetCenter();
+	Input.SurfaceExtent = OtherActorBounds.GetExtent();
 
-		if (!PortalOffsetX)
-		{
-			return std::nullopt;
-		}
+	return Input;
+}
 
-		ResultPoint += PortalOffsetX.value();
+void UPortalGun::UpdatePlacementPreview(
+	FPortalPlacementPreview& Preview,
+	TObjectPtr<APortal> TargetPortal,
+	bool bBlue)
+{
+	if (Preview.SolveTask.IsValid() && Preview.SolveTask.IsCompleted())
+	{
+		Preview.Placement = Preview.SolveTask.GetResult();
+		Preview.SolveTask = {};
 	}
 
+	// Still waiting for the trace or the solver of an earlier frame.
+	if (Preview.TraceHandle.IsValid() || Preview.SolveTask.IsValid())
 	{
-		// Calculate offset to Y axis.
-		const auto PortalOffsetY = MovePortalUAxisAligned(
-			Center,
-			Extent,
-			PortalRight,
-			PortalUp,
-			ResultPoint,
-			FVector(0.0, 1.0, 0.0)
-		);
-
-		if (!PortalOffsetY)
-		{
-			return std::nullopt;
-		}
-
-		ResultPoint += *PortalOffsetY;
+		return;
 	}
 
+	const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>();
+	if (!PortalSubsystem)
 	{
-		// Calculate offset to Z axis.
-		const auto PortalOffsetZ = MovePortalUAxisAligned(
-			Center,
-			Extent,
-			PortalRight,
-			PortalUp,
-			ResultPoint,
-			FVector(0.0, 0.0, 1.0)
-		);
+		return;
+	}
 
-		if (!PortalOffsetZ)
-		{
-			return std::nullopt;
-		}
+	const auto Query = MakeFireRaycastQuery(TargetPortal);
+	const auto& Start = Query.Start;
+	const auto& Direction = Query.Direction;
 
-		ResultPoint += *PortalOffsetZ;
+	// The aim hardly moved, so the last result is still good.
+	if (Preview.AimStart &&
+		FVector::DistSquared(*Preview.AimStart, Start) <=
+			FMath::Square(PORTAL_GUN_PREVIEW_LOCATION_TOLERANCE) &&
+		Preview.AimDirection.Dot(Direction) >=
+			FMath::Cos(FMath::DegreesToRadians(PORTAL_GUN_PREVIEW_ANGLE_TOLERANCE)))
+	{
+		return;
 	}
 
-	return std::make_pair(ResultPoint, PortalRotation);
+	Preview.AimStart = Start;
+	Preview.AimDirection = Direction;
+
+	// The same query as firing. The trace ends short of any other
+	// placed portal, linked or not, where firing stops, so no
+	// placement is previewed on top of the other portal.
+	const auto Trace = PortalSubsystem->MakeRaycastTrace(Query);
+
+	Preview.TraceHandle = GetWorld()->AsyncLineTraceByChannel(
+		EAsyncTraceType::Multi,
+		Trace.Start,
+		Trace.End,
+		Trace.Channel,
+		Trace.CollisionParams,
+		FCollisionResponseParams::DefaultResponseParam,
+		&PlacementPreviewTraceDelegate,
+		bBlue ? 1 : 0);
 }
 
-FQuat UPortalGun::CalculatePortalRotation(const FVector& ImpactNormal, const APortal& TargetPortal) const
+void UPortalGun::OnPlacementPreviewTraced(
+	const FTraceHandle& TraceHandle,
+	FTraceDatum& TraceDatum)
 {
-	FQuat Result;
+	const auto bBlue = TraceDatum.UserData == 1;
+	auto& Preview = bBlue ? BluePlacementPreview : OrangePlacementPreview;
+	const auto& TargetPortal = bBlue ? BluePortal : OrangePortal;
 
+	// Invalidated meanwhile.
+	if (Preview.TraceHandle != TraceHandle)
 	{
-		const auto PortalForward =
-			TargetPortal.GetPortalForwardVector();
-		const auto OldQuat = PortalForward.ToOrientationQuat();
-		const auto NewQuat = ImpactNormal.ToOrientationQuat();
-
-		const auto DiffQuat = NewQuat * OldQuat.Inverse();
-		Result =
-			DiffQuat * TargetPortal.GetTransform().GetRotation();
+		return;
 	}
 
-	// The result calculated before is only correctly for
-	// forward vector, but to rotate correctly for up vector
-	// or right vector, correct with WorldZ.
-	const auto WorldZ = FVector(0.0f, 0.0f, 1.0f);
+	Preview.TraceHandle = FTraceHandle();
+	Preview.Placement.reset();
 
-	if (ImpactNormal.Equals(WorldZ) || ImpactNormal.Equals(-WorldZ))
+	if (TraceDatum.OutHits.IsEmpty())
 	{
-		const auto PortalUp = TargetPortal.GetPortalUpVector(Result);
-
-		const auto TargetPortalUp =
-			Character->GetActorForwardVector();
-
-		const auto RotateAxis =
-			PortalUp.Cross(TargetPortalUp).GetSafeNormal();
-		const auto CosTheta = PortalUp.Dot(TargetPortalUp);
-
-		const auto ThetaRadian = FMath::Acos(CosTheta);
-
-		Result = FQuat(RotateAxis, ThetaRadian) * Result;
+		return;
 	}
-	else
-	{
-		const auto PortalRight = TargetPortal.GetPortalRightVector(Result);
 
-		const FVector TargetPortalRight =
-			FVector::CrossProduct(WorldZ, ImpactNormal).GetSafeNormal();
+	const auto& HitResult = TraceDatum.OutHits[0];
+	const auto HitActor = HitResult.GetActor();
 
-		FVector RotateAxis;
-		if (!PortalRight.Equals(TargetPortalRight))
-		{
-			RotateAxis =
-				PortalRight.Cross(TargetPortalRight).GetSafeNormal();
-			const auto CosTheta = PortalRight.Dot(TargetPortalRight);
-			const auto ThetaRadian = FMath::Acos(CosTheta);
-
-			Result = FQuat(RotateAxis, ThetaRadian) * Result;
-		}
+	if (!HitActor || !CanPlacePortal(HitResult.PhysMaterial.Get()))
+	{
+		return;
 	}
 
-	return Result;
+	// Bounds are read here, so the solver touches no UObject.
+	Preview.SolveTask = UE::Tasks::Launch(
+		UE_SOURCE_LOCATION,
+		[Input = MakePlacementInput(HitResult, *TargetPortal)]()
+		{
+			return FPortalPlacementSolver::Solve(Input);
+		});
 }
 
-UPortalGun::PortalOffset UPortalGun::MovePortalUAxisAligned(
-	const FVector& BoundCenter,
-	const FVector& BoundExtent,
-	const FVector& PortalRight,
-	const FVector& PortalUp,
-	const FVector& PortalCenter,
-	const FVector& U) const
+void UPortalGun::InvalidatePlacementPreviews()
 {
-	const auto BoundCenterU = BoundCenter.Dot(U);
-	const auto BoundExtentU = BoundExtent.Dot(U);
-
-	// Calculate boundary of U coordinate.
-	const auto UMax = FMath::Max(
-		BoundCenterU + BoundExtentU,
-		BoundCenterU - BoundExtentU);
-	const auto UMin = FMath::Min(
-		BoundCenterU + BoundExtentU,
-		BoundCenterU - BoundExtentU);
-
-	const auto PortalUpDotU = PortalUp.Dot(U);
-	const auto PortalRightDotU = PortalRight.Dot(U);
-
-	const auto PortalUSizeHalf =
-		PORTAL_UP_SIZE_HALF * FMath::Abs(PortalUpDotU) +
-		PORTAL_RIGHT_SIZE_HALF * FMath::Abs(PortalRightDotU);
-
-	// Portal.U should be in the boundary:
-	// PortalUMin <= Portal.U < PortalUMax
-	const auto PortalUMax = UMax - PortalUSizeHalf;
-	const auto PortalUMin = UMin + PortalUSizeHalf;
-
-	if (PortalUMax < PortalUMin)
+	for (auto Preview : { &BluePlacementPreview, &OrangePlacementPreview })
 	{
-		// Impossible.
-		return std::nullopt;
+		Preview->AimStart.reset();
+		Preview->TraceHandle = FTraceHandle();
+		Preview->SolveTask = {};
+		Preview->Placement.reset();
 	}
+}
 
-	const auto CenterDotU = PortalCenter.Dot(U);
-	double Delta = 0.0;
+bool UPortalGun::GetPlacementPreview(bool bBlue, FTransform& OutTransform) const
+{
+	const auto& Preview = bBlue ? BluePlacementPreview : OrangePlacementPreview;
 
-	// Should move portal to +U?
-	if (CenterDotU < PortalUMin)
-	{
-		Delta = PortalUMin - CenterDotU;
-	}
-	else if (CenterDotU > PortalUMax)
+	if (!bPlacementPreview || !Preview.Placement)
 	{
-		Delta = PortalUMax - CenterDotU;
+		return false;
 	}
 
-	return Delta * U;
+	OutTransform = FTransform(Preview.Placement->Rotation, Preview.Placement->Location);
+	return true;
 }
 
 void UPortalGun::Interact()
 {
 	if (bIsGrabbing)
 	{
-		UE_LOG(Portal, Log, TEXT("Stop grabbing"));
+		UE_LOG(Portal, Verbose, TEXT("Stop grabbing"));
 		StopGrabbing();
 		// TODO: Stop Tick
 		return;
 	}
 
-	UE_LOG(Portal, Log, TEXT("Try interact"));
+	UE_LOG(Portal, Verbose, TEXT("Try interact"));
 
-	auto Camera = Character->GetFirstPersonCameraComponent();
-
-	const auto Start = Camera->GetComponentLocation();
-	const auto Direction = Camera->GetForwardVector();
-	const auto End = Start + Direction * PORTAL_GUN_GRAB_RANGE;
-
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(Character);
-	CollisionParams.AddIgnoredComponent(BluePortal->PortalEnterMask);
-	CollisionParams.AddIgnoredComponent(OrangePortal->PortalEnterMask);
-
-	TArray<FHitResult> HitResults;
-
-	auto bIsBlocked = GetWorld()->LineTraceMultiByChannel(
-		HitResults,
-		Start,
-		End,
-		PORTAL_QUERY,
-		CollisionParams);
-
-	auto bNothingToInteract = HitResults.IsEmpty();
-
-	if (bNothingToInteract)
+	const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>();
+	if (!PortalSubsystem)
 	{
-		UE_LOG(Portal, Log, TEXT("Nothing to interact"));
 		return;
 	}
 
-	auto HitResult = HitResults[0];
-	bIsGrabbedObjectAcrossedPortal = false;
+	const auto Result = PortalSubsystem->Raycast(
+		MakeCameraRaycastQuery(PORTAL_GUN_GRAB_RANGE, PORTAL_QUERY));
 
-	if (auto PortalOpt = APortal::CastPortal(HitResult.GetActor()))
+	if (!Result.Hit)
 	{
-		UE_LOG(Portal, Log, TEXT("Hit Portal, try grab beyond the opposite space"));
-		auto PortalActor = *PortalOpt;
-
-		const auto ImpactPoint = HitResult.ImpactPoint;
-		const auto RemainRange =
-			(End - ImpactPoint).Length();
-
-		const auto OppositeDirection =
-			PortalActor->TransformVectorToDestSpace(Direction);
-
-		const auto OppositePortalForward =
-			PortalActor->GetLink()->GetPortalForwardVector();
-
-		// We should move start point little because
-		// prevent to hit the wall mesh.
-		constexpr auto ForwardOffset = 10.f;
-		const auto DirectionDotForward =
-			OppositeDirection.Dot(OppositePortalForward);
+		UE_LOG(Portal, Verbose, TEXT("Nothing to interact"));
+		return;
+	}
 
-		const auto StartOffset =
-			ForwardOffset / DirectionDotForward;
-		
-		const auto OppositeStart =
-			PortalActor->TransformPointToDestSpace(ImpactPoint) +
-			OppositeDirection * StartOffset;
-		const auto OppositeEnd =
-			OppositeStart + OppositeDirection * RemainRange;
-		
-		CollisionParams.AddIgnoredActor(BluePortal);
-		CollisionParams.AddIgnoredActor(OrangePortal);
-
-		bIsBlocked = GetWorld()->LineTraceMultiByChannel(
-			HitResults,
-			OppositeStart,
-			OppositeEnd,
-			PORTAL_QUERY,
-			CollisionParams);
-
-		bNothingToInteract = HitResults.IsEmpty();
-		if (bNothingToInteract)
-		{
-			UE_LOG(Portal, Log, TEXT("Nothing to interact."));
-			return;
-		}
+	const auto& HitResult = *Result.Hit;
+	bIsGrabbedObjectAcrossedPortal = !Result.PassedPortals.IsEmpty();
 
-		bIsGrabbedObjectAcrossedPortal = true;
-		HitResult = HitResults[0];
+	if (bIsGrabbedObjectAcrossedPortal)
+	{
+		UE_LOG(Portal, Verbose, TEXT("Hit Portal, grab beyond the opposite space"));
 	}
 
 	auto NewGrabbedActor = HitResult.GetActor();
 	if (!CanGrab(NewGrabbedActor))
 	{
-		UE_LOG(Portal, Log, TEXT("Cannot grab the actor: %s"), *NewGrabbedActor->GetName());
+		UE_LOG(Portal, Verbose, TEXT("Cannot grab the actor: %s"), *NewGrabbedActor->GetName());
 		return;
 	}
 
@@ -859,7 +1113,7 @@ void UPortalGun::Interact()
 
 	if (const auto OriginalActor = GetOriginalIfClone(NewGrabbedActor))
 	{
-		UE_LOG(Portal, Log, TEXT("Grabbed clone"));
+		UE_LOG(Portal, Verbose, TEXT("Grabbed clone"));
 		NewGrabbedActor = *OriginalActor;
 		bIsGrabbedObjectAcrossedPortal = !bIsGrabbedObjectAcrossedPortal;
 	}
@@ -872,6 +1126,13 @@ void UPortalGun::ResetPortal()
 {
 	BluePortal->Deactivate();
 	OrangePortal->Deactivate();
+	UpdatePortalContactModifier();
+	InvalidatePlacementPreviews();
+
+	if (const auto PortalSubsystem = GetWorld()->GetSubsystem<UPortalSubsystem>())
+	{
+		PortalSubsystem->InvalidateRaycasts();
+	}
 }
 
 void UPortalGun::StopGrabbing()
@@ -890,8 +1151,14 @@ void UPortalGun::StopGrabbing()
 
 void UPortalGun::StartGrabbing(AActor* const NewGrabbedActor)
 {
+	++GrabId;
 	bIsGrabbing = true;
 	GrabbedActor = NewGrabbedActor;
+
+	if (const auto PrimitiveCompOpt = GetPrimitiveComponent(GrabbedActor))
+	{
+		(*PrimitiveCompOpt)->WakeRigidBody();
+	}
 }
 
 bool UPortalGun::CanGrab(AActor* Actor)
@@ -909,57 +1176,6 @@ std::optional<TObjectPtr<AActor>> UPortalGun::GetOriginalIfClone(AActor* Actor)
 	return OrangePortal->GetOriginalIfClone(Actor);
 }
 
-std::optional<TObjectPtr<APortal>> UPortalGun::GetPortalInFrontOfCharacter()
-{
-	UE_LOG(Portal, Log, TEXT("Try get portal in front of the character."))
-	const auto CameraComponent = Character->GetFirstPersonCameraComponent();
-	const auto Start =
-		CameraComponent->GetComponentLocation();
-	const auto Direction =
-		CameraComponent->GetForwardVector();
-	const auto End = Start + Direction * PORTAL_GUN_GRAB_RANGE;
-
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(Character);
-	CollisionParams.AddIgnoredComponent(BluePortal->PortalEnterMask);
-	CollisionParams.AddIgnoredComponent(OrangePortal->PortalEnterMask);
-
-	FCollisionResponseParams ResponseParams;
-	ResponseParams.CollisionResponse = ECR_Overlap;
-
-	TArray<FHitResult> HitResults;
-
-	GetWorld()->LineTraceMultiByChannel(
-		HitResults,
-		Start,
-		End,
-		PORTAL_QUERY,
-		CollisionParams);
-	
-	for (auto HitResult : HitResults)
-	{
-		auto PortalOpt =
-			APortal::CastPortal(HitResult.GetActor());
-
-		if (!PortalOpt)
-		{
-			continue;
-		}
-
-		if (auto CapsuleComp =
-			Cast<UCapsuleComponent>(HitResult.GetComponent()))
-		{
-			// Hard coded to ignore capsule component in the portal.
-			UE_LOG(Portal, Log, TEXT("Hitted the CapsuleComponent, but ignore it."));
-			continue;
-		}
-
-		return *PortalOpt;
-	}
-
-	return std::nullopt;
-}
-
 void UPortalGun::OnActorPassedPortal(
 	TObjectPtr<APortal> PassedPortal,
 	TObjectPtr<AActor> PassingActor)
@@ -969,7 +1185,7 @@ void UPortalGun::OnActorPassedPortal(
 		return;
 	}
 
-	UE_LOG(Portal, Log, TEXT("The grabbed object acrossed the portal"));
+	UE_LOG(Portal, Verbose, TEXT("The grabbed object acrossed the portal"));
 	if (PassingActor->GetUniqueID() == Character->GetUniqueID())
 	{
 		bIsGrabbedObjectAcrossedPortal = !bIsGrabbedObjectAcrossedPortal;
@@ -985,71 +1201,12 @@ void UPortalGun::TickComponent(float DeltaTime, ELevelTick TickType, FActorCompo
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	ForceGrabbedObject();
-}
-
-void UPortalGun::ForceGrabbedObject()
-{
-	if (!bIsGrabbing)
-	{
-		return;
-	}
-
-	const auto CameraComponent = Character->GetFirstPersonCameraComponent();
-	const auto CameraLocation =
-		CameraComponent->GetComponentLocation();
-	const auto CameraDirection =
-		CameraComponent->GetForwardVector();
-
-	auto TargetLocation =
-		CameraLocation +
-		CameraDirection * PORTAL_GUN_GRAB_OFFSET;
-	auto CurrentLocation = GrabbedActor->GetActorLocation();
+	UpdatePortalGrabController();
+	ProjectilePool.Tick(DeltaTime);
 
-	if (bIsGrabbedObjectAcrossedPortal)
+	if (bPlacementPreview && Character)
 	{
-		if (auto PortalOpt = GetPortalInFrontOfCharacter())
-		{
-			const auto& PortalInFront = *PortalOpt;
-			TargetLocation =
-				PortalInFront->TransformPointToDestSpace(TargetLocation);
-		}
-		else
-		{
-			// Stop grabbing if the object is opposite space and
-			// the character cannot see the object.
-			UE_LOG(Portal, Log, TEXT("Cannot see object through portal: Cancel grab"));
-			StopGrabbing();
-			return;
-		}
+		UpdatePlacementPreview(BluePlacementPreview, BluePortal, true);
+		UpdatePlacementPreview(OrangePlacementPreview, OrangePortal, false);
 	}
-
-	auto Direction = TargetLocation - CurrentLocation;
-	auto Length = Direction.Length();
-	Direction.Normalize();
-
-	if (Length > PORTAL_GUN_GRAB_OFFSET * 2.0f)
-	{
-		// Stop grabbing if the object is too far.
-		UE_LOG(Portal, Log, TEXT("Object is too far: Cancel grab."));
-		UE_LOG(Portal, Log, TEXT("The grabbed actor location was: %s"), *CurrentLocation.ToString());
-		UE_LOG(Portal, Log, TEXT("The location to move the grabbed actor was: %s"), *TargetLocation.ToString());
-		StopGrabbing();
-		return;
-	}
-
-
-	auto PrimitiveCompOpt = GetPrimitiveComponent(GrabbedActor);
-
-	if (!PrimitiveCompOpt)
-		return;
-
-	auto PrimitiveComp = *PrimitiveCompOpt;
-
-	const auto Velocity =
-		Direction * Length * PORTAL_GUN_GRAB_FORCE_MULTIPLIER;
-
-	PrimitiveComp->SetAllPhysicsLinearVelocity(Velocity);
-	PrimitiveComp->SetAllPhysicsAngularVelocityInDegrees(
-		FVector(0.0));
 }
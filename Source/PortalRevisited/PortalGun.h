@@ -5,7 +5,11 @@
 #include <optional>
 
 #include "CoreMinimal.h"
+#include "PortalPlacementSolver.h"
+#include "PortalProjectilePool.h"
+#include "WorldCollision.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Tasks/Task.h"
 #include "PortalGun.generated.h"
 
 class APortalRevisitedCharacter;
@@ -13,6 +17,22 @@ class UInputMappingContext;
 class UInputAction;
 class APortal;
 class AStaticMeshActor;
+class FPortalContactModifier;
+class FPortalGrabController;
+struct FPortalRaycastQuery;
+
+/** Where a portal would land if fired, updated asynchronously. */
+struct FPortalPlacementPreview
+{
+	/** The aim of the latest trace. */
+	std::optional<FVector> AimStart;
+	FVector AimDirection;
+
+	FTraceHandle TraceHandle;
+	UE::Tasks::TTask<std::optional<FPortalPlacement>> SolveTask;
+
+	std::optional<FPortalPlacement> Placement;
+};
 
 /**
  * 
@@ -23,7 +43,6 @@ class PORTALREVISITED_API UPortalGun : public USkeletalMeshComponent
 	GENERATED_BODY()
 
 	using PortalCenterAndNormal = std::optional<std::pair<FVector, FQuat>>;
-	using PortalOffset = std::optional<FVector>;
 public:
 	UPortalGun();
 	void LinkPortals();
@@ -32,6 +51,19 @@ public:
 	UPROPERTY(EditAnywhere, Category=Projectile)
 	TSubclassOf<class APortalRevisitedProjectile> ProjectileClass;
 
+	/**
+	 * Draw projectiles as instances of ProjectileMesh moving toward
+	 * the impact point, without actors or collision.
+	 */
+	UPROPERTY(EditAnywhere, Category=Projectile)
+	bool bInstancedProjectiles;
+
+	UPROPERTY(EditAnywhere, Category=Projectile, meta=(EditCondition="bInstancedProjectiles"))
+	TObjectPtr<UStaticMesh> ProjectileMesh;
+
+	UPROPERTY(EditAnywhere, Category=Projectile, meta=(EditCondition="bInstancedProjectiles"))
+	FVector ProjectileMeshScale;
+
 	/** Sound to play each time we fire blue portal*/
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	TObjectPtr<USoundBase> BlueFireSound;
@@ -54,6 +86,21 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Portal")
 	TObjectPtr<APortal> OrangePortal;
 
+	/**
+	 * Teleport simulated bodies on the physics thread at every physics
+	 * step, instead of on the game thread once a frame.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Portal")
+	bool bPhysicsThreadTeleport;
+
+	/**
+	 * Keep where each portal would land if fired up to date, for a
+	 * reticle or a ghost. Traced asynchronously and solved off the
+	 * game thread, only when the aim moves.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Portal")
+	bool bPlacementPreview;
+
 	TObjectPtr<UTextureRenderTarget2D> BluePortalRenderTarget;
 	TObjectPtr<UTextureRenderTarget2D> OrangePortalRenderTarget;
 	TObjectPtr<UMaterialInterface> BluePortalMaterial;
@@ -95,6 +142,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category="PortalGun")
 	void Interact();
 
+	/** @return true if the portal would land at OutTransform if fired. */
+	UFUNCTION(BlueprintCallable, Category="PortalGun")
+	bool GetPlacementPreview(bool bBlue, FTransform& OutTransform) const;
+
 	void ResetPortal();
 
 	void OnActorPassedPortal(
@@ -106,38 +157,65 @@ public:
 		ELevelTick TickType,
 		FActorComponentTickFunction* ThisTickFunction) override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 	void FirePortal(TObjectPtr<APortal> TargetPortal);
 	void FirePortalProjectile(const FVector& ImpactPoint, bool CanCreatePortal);
+	/** The ray from the camera, ignoring the character. */
+	FPortalRaycastQuery MakeCameraRaycastQuery(double Range, ECollisionChannel Channel) const;
+	/** The ray of firing, which stops at any portal but the fired one. */
+	FPortalRaycastQuery MakeFireRaycastQuery(TObjectPtr<APortal> TargetPortal) const;
 	/**
 	 * @brief 
 	 * @param The actor like walls 
 	 * @return true if the portal can be placed on the actor.
 	 */
 	bool CanPlacePortal(UPhysicalMaterial* WallPhysicalMaterial);
-	void SpawnPlanesAroundPortal(TObjectPtr<APortal> TargetPortal);
+	/**
+	 * Re-pose the pooled planes on the ground in front of the portal.
+	 * Unused planes of the pool have collision disabled.
+	 */
+	void UpdatePlanesAroundPortal(TObjectPtr<APortal> TargetPortal);
+	void CreatePlanePool(TArray<TObjectPtr<AStaticMeshActor>>& TargetCollisionPlanes);
+	void CreateProjectilePool();
+	/**
+	 * @return true if the plane query in front of the target portal
+	 * reaches the rectangle of a portal at the location and rotation.
+	 */
+	bool IsInPlaneQueryRange(
+		const APortal& TargetPortal,
+		const FVector& PortalLocation,
+		const FQuat& PortalQuat) const;
+
+	void RegisterPortalContactModifier();
+	void UnregisterPortalContactModifier();
+	/** Send the current portal openings to the physics thread. */
+	void UpdatePortalContactModifier();
+
+	void RegisterPortalGrabController();
+	void UnregisterPortalGrabController();
+	/** Send the grab of this frame to the physics thread. */
+	void UpdatePortalGrabController();
 	
 	TArray<TObjectPtr<AStaticMeshActor>>& GetCollisionPlanes(
 		TObjectPtr<APortal> TargetPortal);
 
-	void DestroyAllPlanesSpawnedBefore(
-		TArray<TObjectPtr<AStaticMeshActor>>& TargetCollisionPlanes);
-
 	PortalCenterAndNormal CalculateCorrectPortalCenter(
 		const FHitResult& HitResult, 
 		const APortal& TargetPortal) const;
-	
-	FQuat CalculatePortalRotation(
-		const FVector& ImpactNormal,
+
+	FPortalPlacementInput MakePlacementInput(
+		const FHitResult& HitResult,
 		const APortal& TargetPortal) const;
 
-	PortalOffset MovePortalUAxisAligned(
-		const FVector& BoundCenter,
-		const FVector& BoundExtent,
-		const FVector& PortalRight,
-		const FVector& PortalUp,
-		const FVector& PortalCenter,
-		const FVector& U) const;
+	void UpdatePlacementPreview(
+		FPortalPlacementPreview& Preview,
+		TObjectPtr<APortal> TargetPortal,
+		bool bBlue);
+	void OnPlacementPreviewTraced(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	/** Trace again, as a portal moved. */
+	void InvalidatePlacementPreviews();
 
 	FVector CalculateOffset(
 		const FVector& PortalForward, 
@@ -150,9 +228,6 @@ private:
 	void StartGrabbing(AActor* NewGrabbedActor);
 	bool CanGrab(AActor* Actor);
 	std::optional<TObjectPtr<AActor>> GetOriginalIfClone(AActor* Actor);
-	std::optional<TObjectPtr<APortal>> GetPortalInFrontOfCharacter();
-
-	void ForceGrabbedObject();
 
 private:
 	/** The Character holding this weapon*/
@@ -163,7 +238,17 @@ private:
 	TArray<TObjectPtr<AStaticMeshActor>> BluePortalPlanes;
 	TArray<TObjectPtr<AStaticMeshActor>> OrangePortalPlanes;
 
+	FPortalProjectilePool ProjectilePool;
+
+	FPortalContactModifier* PortalContactModifier;
+	FPortalGrabController* PortalGrabController;
+
 	bool bIsGrabbing;
 	bool bIsGrabbedObjectAcrossedPortal;
 	TObjectPtr<AActor> GrabbedActor;
+	uint32 GrabId;
+
+	FPortalPlacementPreview BluePlacementPreview;
+	FPortalPlacementPreview OrangePlacementPreview;
+	FTraceDelegate PlacementPreviewTraceDelegate;
 };
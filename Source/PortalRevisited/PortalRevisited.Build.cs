@@ -16,6 +16,8 @@ public class PortalRevisited : ModuleRules
 			"RHI",
 			"RenderCore",
 			"HeadMountedDisplay",
+			"PhysicsCore",
+			"Chaos",
 			"EnhancedInput" });
 	}
 }
@@ -1,7 +1,16 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PortalRevisited.h"
+#include "PortalDebugOverlay.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PortalRevisited, "PortalRevisited" );
- 
\ No newline at end of file
+class FPortalRevisitedModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void ShutdownModule() override
+	{
+		FPortalDebugOverlay::Shutdown();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FPortalRevisitedModule, PortalRevisited, "PortalRevisited" );
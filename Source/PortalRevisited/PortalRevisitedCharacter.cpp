@@ -2,6 +2,7 @@
 
 #include "PortalRevisitedCharacter.h"
 #include "PortalRevisitedProjectile.h"
+#include "PortalCharacterMovementComponent.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -16,7 +17,9 @@
 //////////////////////////////////////////////////////////////////////////
 // APortalRevisitedCharacter
 
-APortalRevisitedCharacter::APortalRevisitedCharacter()
+APortalRevisitedCharacter::APortalRevisitedCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UPortalCharacterMovementComponent>(
+		ACharacter::CharacterMovementComponentName))
 {
 	// Character doesnt have a rifle at start
 	bHasPortalGun = false;
@@ -42,7 +42,7 @@ class APortalRevisitedCharacter : public ACharacter
 	
 public:
 
-	APortalRevisitedCharacter();
+	APortalRevisitedCharacter(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	virtual void BeginPlay();
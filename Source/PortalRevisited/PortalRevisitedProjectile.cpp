@@ -4,12 +4,14 @@
 
 #include <stdexcept>
 
-#include "GameFramework/ProjectileMovementComponent.h"
+#include "PortalProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
+#include "TimerManager.h"
 
 DEFINE_LOG_CATEGORY(PortalProjectile);
 
 APortalRevisitedProjectile::APortalRevisitedProjectile() 
+	: bIsInUse(false)
 {
 	// Use a sphere as a simple collision representation
 	CollisionComp = CreateDefaultSubobject<USphereComponent>(TEXT("SphereComp"));
@@ -24,8 +26,9 @@ APortalRevisitedProjectile::APortalRevisitedProjectile()
 	// Set as root component
 	RootComponent = CollisionComp;
 
-	// Use a ProjectileMovementComponent to govern this projectile's movement
-	ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileComp"));
+	// Use a ProjectileMovementComponent to govern this projectile's movement,
+	// which passes portals by itself
+	ProjectileMovement = CreateDefaultSubobject<UPortalProjectileMovementComponent>(TEXT("ProjectileComp"));
 	ProjectileMovement->UpdatedComponent = CollisionComp;
 	ProjectileMovement->InitialSpeed = 3000.f;
 	ProjectileMovement->MaxSpeed = 3000.f;
@@ -33,8 +36,9 @@ APortalRevisitedProjectile::APortalRevisitedProjectile()
 	ProjectileMovement->bShouldBounce = false;
 	ProjectileMovement->ProjectileGravityScale = 0.0f;
 
-	// Die after 3 seconds by default
-	InitialLifeSpan = 1.0f;
+	// Pooled projectiles are released after PORTAL_PROJECTILE_LIFE_SPAN
+	// instead of being destroyed.
+	InitialLifeSpan = 0.0f;
 }
 
 void APortalRevisitedProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -42,8 +46,8 @@ void APortalRevisitedProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* Oth
 	// Only add impulse and destroy projectile if we hit a physics
 	if ((OtherActor) && (OtherActor != this) && (OtherComp))
 	{
-		UE_LOG(PortalProjectile, Log, TEXT("PortalProjectile: Projectile destroyed."));
-		Destroy();
+		UE_LOG(PortalProjectile, Verbose, TEXT("PortalProjectile: Projectile released."));
+		Release();
 	}
 }
 
@@ -56,3 +60,38 @@ void APortalRevisitedProjectile::SetPrjectileDestination(const FVector NewDestin
 {
 	Destination = NewDestination;
 }
+
+void APortalRevisitedProjectile::Launch(
+	const FVector& Location,
+	const FRotator& Rotation,
+	const FVector& NewDestination)
+{
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetPrjectileDestination(NewDestination);
+
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// The movement forgets the component when it stops.
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = Rotation.Vector() * ProjectileMovement->InitialSpeed;
+
+	GetWorldTimerManager().SetTimer(
+		ReleaseTimerHandle,
+		this,
+		&APortalRevisitedProjectile::Release,
+		PORTAL_PROJECTILE_LIFE_SPAN);
+
+	bIsInUse = true;
+}
+
+void APortalRevisitedProjectile::Release()
+{
+	GetWorldTimerManager().ClearTimer(ReleaseTimerHandle);
+
+	ProjectileMovement->StopMovementImmediately();
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+
+	bIsInUse = false;
+}
@@ -4,12 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "PortalLog.h"
 #include "PortalRevisitedProjectile.generated.h"
 
 class USphereComponent;
 class UProjectileMovementComponent;
 
-DECLARE_LOG_CATEGORY_EXTERN(PortalProjectile, Log, All);
+DECLARE_LOG_CATEGORY_EXTERN(PortalProjectile, Log, PORTAL_LOG_COMPILE_VERBOSITY);
+
+constexpr float PORTAL_PROJECTILE_LIFE_SPAN = 1.0f;
 
 UCLASS(config=Game)
 class APortalRevisitedProjectile : public AActor
@@ -40,9 +43,18 @@ public:
 
 	void SetPrjectileDestination(const FVector NewDestination);
 
+	/** Fire the pooled projectile again from the location. */
+	void Launch(const FVector& Location, const FRotator& Rotation, const FVector& NewDestination);
+	/** Hide the projectile and stop it, to be launched again. */
+	void Release();
+	bool IsInUse() const { return bIsInUse; }
+
 private:
 	bool bCanCreatePortal;
 	FVector Destination;
 
+	bool bIsInUse;
+	FTimerHandle ReleaseTimerHandle;
+
 };
 
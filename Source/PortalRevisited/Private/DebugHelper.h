@@ -1,146 +1,76 @@
 #pragma once
 
+// On-screen output for development only. Shipping builds draw and
+// print nothing, and keep none of this code.
+#if !UE_BUILD_SHIPPING
+
+#include "DrawDebugHelpers.h"
+#include "PortalDebugOverlay.h"
+
+// Lines go to the portal debug overlay, shown by portal.Debug.General.
+// A line with a key replaces its last line instead of adding another.
 class DebugHelper
 {
 public:
 	
-	static void PrintText(const wchar_t* Message)
+	static void PrintText(
+		const wchar_t* Message,
+		int32 Key = FPortalDebugOverlay::NO_KEY)
 	{
-		if (!GEngine)
-			return;
-
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			Message
-		);
+		FPortalDebugOverlay::Printf(
+			EPortalDebugCategory::General,
+			Key,
+			TEXT("%s"),
+			Message);
 	}
 
-	static void PrintText(const FString& Message)
+	static void PrintText(
+		const FString& Message,
+		int32 Key = FPortalDebugOverlay::NO_KEY)
 	{
-		if (!GEngine)
-			return;
-
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			Message
-		);
+		PrintText(*Message, Key);
 	}
 
-	static void PrintText(const double Value)
+	static void PrintText(
+		const double Value,
+		int32 Key = FPortalDebugOverlay::NO_KEY)
 	{
-		if (!GEngine)
-			return;
-
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			FString::SanitizeFloat(Value)
-		);
+		FPortalDebugOverlay::Printf(
+			EPortalDebugCategory::General,
+			Key,
+			TEXT("%f"),
+			Value);
 	}
 	
-	static void PrintVector(const FVector& Vector)
+	static void PrintVector(
+		const FVector& Vector,
+		int32 Key = FPortalDebugOverlay::NO_KEY)
 	{
-		if (!GEngine)
-			return;
-
-		FString VectorText =
-			TEXT("(") +
-			FString::SanitizeFloat(Vector.X) +
-			TEXT(",") +
-			FString::SanitizeFloat(Vector.Y) +
-			TEXT(",") +
-			FString::SanitizeFloat(Vector.Z) +
-			TEXT(")");
-
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			VectorText
-		);
+		FPortalDebugOverlay::Printf(
+			EPortalDebugCategory::General,
+			Key,
+			TEXT("(%f,%f,%f)"),
+			Vector.X,
+			Vector.Y,
+			Vector.Z);
 	}
 	
-	static void PrintMatrix(const FMatrix& Matrix)
+	/** A keyed matrix takes four keys from Key. */
+	static void PrintMatrix(
+		const FMatrix& Matrix,
+		int32 Key = FPortalDebugOverlay::NO_KEY)
 	{
-		if (!GEngine)
-			return;
-
-		FString MatrixRow0 =
-			TEXT("[") +
-			FString::SanitizeFloat(Matrix.M[0][0]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[0][1]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[0][2]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[0][3]) +
-			TEXT("]");
-		
-		FString MatrixRow1 =
-			TEXT("[") +
-			FString::SanitizeFloat(Matrix.M[1][0]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[1][1]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[1][2]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[1][3]) +
-			TEXT("]");
-		
-		FString MatrixRow2 =
-			TEXT("[") +
-			FString::SanitizeFloat(Matrix.M[2][0]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[2][1]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[2][2]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[2][3]) +
-			TEXT("]");
-		
-		FString MatrixRow3 =
-			TEXT("[") +
-			FString::SanitizeFloat(Matrix.M[3][0]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[3][1]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[3][2]) +
-			TEXT(",") +
-			FString::SanitizeFloat(Matrix.M[3][3]) +
-			TEXT("]");
-
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			MatrixRow3
-		);
-		
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			MatrixRow2
-		);
-		
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			MatrixRow1
-		);
-		
-		GEngine->AddOnScreenDebugMessage(
-			-1,
-			5.f,
-			FColor::Red,
-			MatrixRow0
-		);
+		for (int32 Row = 0; Row < 4; ++Row)
+		{
+			FPortalDebugOverlay::Printf(
+				EPortalDebugCategory::General,
+				Key == FPortalDebugOverlay::NO_KEY ? Key : Key + Row,
+				TEXT("[%f,%f,%f,%f]"),
+				Matrix.M[Row][0],
+				Matrix.M[Row][1],
+				Matrix.M[Row][2],
+				Matrix.M[Row][3]);
+		}
 	}
 
 	static void DrawLine(
@@ -148,7 +78,7 @@ public:
 		const FVector& Direction,
 		const FColor& Color = FColor::Red)
 	{
-		if (!GEngine)
+		if (!FPortalDebugOverlay::IsEnabled(EPortalDebugCategory::General))
 			return;
 
 		constexpr float LINE_LENGTH = 500.f;
@@ -165,10 +95,36 @@ public:
 		const FVector& Position,
 		const FColor& Color = FColor::Red)
 	{
+		if (!FPortalDebugOverlay::IsEnabled(EPortalDebugCategory::General))
+			return;
+
 		DrawDebugPoint(
 			GWorld,
 			Position,
 			5.0f,
 			Color);
 	}
-};
\ No newline at end of file
+};
+
+#else
+
+class DebugHelper
+{
+public:
+	template<typename... ArgTypes>
+	static void PrintText(ArgTypes&&...) {}
+
+	template<typename... ArgTypes>
+	static void PrintVector(ArgTypes&&...) {}
+
+	template<typename... ArgTypes>
+	static void PrintMatrix(ArgTypes&&...) {}
+
+	template<typename... ArgTypes>
+	static void DrawLine(ArgTypes&&...) {}
+
+	template<typename... ArgTypes>
+	static void DrawPoint(ArgTypes&&...) {}
+};
+
+#endif
@@ -0,0 +1,340 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalCharacterMovementComponent.h"
+
+#include "Camera/CameraComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Controller.h"
+#include "PortalRevisited/Portal.h"
+#include "PortalRevisited/PortalRevisitedCharacter.h"
+
+// How far the capsule may be from the portal plane or the portal edges
+// and still be regarded as walking into the portal.
+constexpr float PORTAL_THROAT_MARGIN = 10.f;
+// How many portal walls a single move may pass.
+constexpr int32 PORTAL_MAX_PASSED_SURFACES = 2;
+
+UPortalCharacterMovementComponent::UPortalCharacterMovementComponent()
+	: bIsMovingThroughPortal(false)
+{
+}
+
+void UPortalCharacterMovementComponent::RegisterPortal(TObjectPtr<APortal> Portal)
+{
+	if (!Portal)
+	{
+		return;
+	}
+
+	Portals.AddUnique(Portal);
+}
+
+void UPortalCharacterMovementComponent::UnregisterPortal(TObjectPtr<APortal> Portal)
+{
+	Portals.Remove(Portal);
+}
+
+bool UPortalCharacterMovementComponent::HandlesPortalTraversal(const AActor& Actor)
+{
+	const auto Character = Cast<ACharacter>(&Actor);
+	if (!Character)
+	{
+		return false;
+	}
+
+	return Cast<UPortalCharacterMovementComponent>(
+		Character->GetCharacterMovement()) != nullptr;
+}
+
+bool UPortalCharacterMovementComponent::MoveUpdatedComponentImpl(
+	const FVector& Delta,
+	const FQuat& NewRotation,
+	bool bSweep,
+	FHitResult* OutHit,
+	ETeleportType Teleport)
+{
+	if (bIsMovingThroughPortal || !UpdatedComponent || !CharacterOwner)
+	{
+		return Super::MoveUpdatedComponentImpl(
+			Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	const auto CrossedPortalOpt = FindCrossedPortal(Delta);
+	if (!CrossedPortalOpt)
+	{
+		return MoveThroughPortalOpenings(
+			Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	const auto [Portal, Fraction] = *CrossedPortalOpt;
+	TGuardValue<bool> MovingThroughPortalGuard(bIsMovingThroughPortal, true);
+
+	// Move until the camera reaches the portal plane.
+	FHitResult Hit(1.f);
+	const auto bMovedToPortal = MoveThroughPortalOpenings(
+		Delta * Fraction, NewRotation, bSweep, &Hit, Teleport);
+
+	if (Hit.bBlockingHit)
+	{
+		Hit.Time *= Fraction;
+		if (OutHit)
+		{
+			*OutHit = Hit;
+		}
+		return bMovedToPortal;
+	}
+
+	TeleportThroughPortal(*Portal);
+
+	// Continue the remaining move from the linked portal.
+	const auto RemainingDelta =
+		Portal->TransformVectorToDestSpace(Delta * (1.0 - Fraction));
+
+	const auto bMovedFromPortal = MoveThroughPortalOpenings(
+		RemainingDelta,
+		UpdatedComponent->GetComponentQuat(),
+		bSweep,
+		&Hit,
+		Teleport);
+
+	if (Hit.bBlockingHit)
+	{
+		Hit.Time = Fraction + (1.0 - Fraction) * Hit.Time;
+	}
+
+	if (OutHit)
+	{
+		*OutHit = Hit;
+	}
+
+	return bMovedToPortal || bMovedFromPortal;
+}
+
+FVector UPortalCharacterMovementComponent::GetTraversalLocation() const
+{
+	// The player passes the portal when the camera does, so the
+	// screen never shows the wall behind the portal.
+	if (const auto Player =
+		Cast<APortalRevisitedCharacter>(CharacterOwner))
+	{
+		return Player->GetFirstPersonCameraComponent()
+			->GetComponentLocation();
+	}
+
+	return UpdatedComponent->GetComponentLocation();
+}
+
+UPortalCharacterMovementComponent::CrossedPortal
+UPortalCharacterMovementComponent::FindCrossedPortal(const FVector& Delta) const
+{
+	const auto Start = GetTraversalLocation();
+	const auto End = Start + Delta;
+
+	CrossedPortal Result = std::nullopt;
+
+	for (const auto& Portal : Portals)
+	{
+		if (!Portal || !Portal->IsActivated())
+		{
+			continue;
+		}
+
+		const auto LinkedPortal = Portal->GetLink();
+		if (!LinkedPortal || !LinkedPortal->IsActivated())
+		{
+			continue;
+		}
+
+		const auto PortalLocation = Portal->GetPortalPlaneLocation();
+		const auto PortalForward = Portal->GetPortalForwardVector();
+
+		if (!APortal::DoesSegmentCrossPortal(
+			Start,
+			End,
+			PortalLocation,
+			PortalForward,
+			Portal->GetPortalRightVector(),
+			Portal->GetPortalUpVector()))
+		{
+			continue;
+		}
+
+		const auto StartDistance =
+			FVector::DotProduct(Start - PortalLocation, PortalForward);
+		const auto EndDistance =
+			FVector::DotProduct(End - PortalLocation, PortalForward);
+		const auto Fraction =
+			StartDistance / (StartDistance - EndDistance);
+
+		if (!Result || Fraction < Result->second)
+		{
+			Result = std::make_pair(Portal, Fraction);
+		}
+	}
+
+	return Result;
+}
+
+bool UPortalCharacterMovementComponent::IsCapsuleInPortalThroat(const APortal& Portal) const
+{
+	float Radius;
+	float HalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(
+		Radius,
+		HalfHeight);
+
+	const auto PortalToCapsule =
+		UpdatedComponent->GetComponentLocation() -
+		Portal.GetPortalPlaneLocation();
+
+	const auto Distance =
+		PortalToCapsule.Dot(Portal.GetPortalForwardVector());
+
+	if (FMath::Abs(Distance) > Radius + PORTAL_THROAT_MARGIN)
+	{
+		return false;
+	}
+
+	// Half extents of the capsule along the portal axes.
+	const auto CapsuleUp = UpdatedComponent->GetUpVector();
+	const auto PortalUp = Portal.GetPortalUpVector();
+	const auto PortalRight = Portal.GetPortalRightVector();
+
+	const auto UpExtent =
+		Radius + (HalfHeight - Radius) * FMath::Abs(CapsuleUp.Dot(PortalUp));
+	const auto RightExtent =
+		Radius + (HalfHeight - Radius) * FMath::Abs(CapsuleUp.Dot(PortalRight));
+
+	return
+		FMath::Abs(PortalToCapsule.Dot(PortalUp)) + UpExtent <=
+			PORTAL_UP_SIZE_HALF + PORTAL_THROAT_MARGIN &&
+		FMath::Abs(PortalToCapsule.Dot(PortalRight)) + RightExtent <=
+			PORTAL_RIGHT_SIZE_HALF + PORTAL_THROAT_MARGIN;
+}
+
+bool UPortalCharacterMovementComponent::IsHitInPortalOpening(const FHitResult& Hit) const
+{
+	const auto Surface = Hit.GetComponent();
+	if (!Surface)
+	{
+		return false;
+	}
+
+	for (const auto& Portal : Portals)
+	{
+		if (!Portal || !Portal->IsActivated() || Portal->GetHostSurface() != Surface)
+		{
+			continue;
+		}
+
+		const auto LinkedPortal = Portal->GetLink();
+		if (!LinkedPortal || !LinkedPortal->IsActivated())
+		{
+			continue;
+		}
+
+		// The capsule should fit in the opening, so its sides never
+		// pass the wall around it.
+		if (!IsCapsuleInPortalThroat(*Portal))
+		{
+			continue;
+		}
+
+		const auto PortalToImpact =
+			Hit.ImpactPoint - Portal->GetPortalPlaneLocation();
+
+		if (FMath::Abs(PortalToImpact.Dot(Portal->GetPortalRightVector())) < PORTAL_RIGHT_SIZE_HALF &&
+			FMath::Abs(PortalToImpact.Dot(Portal->GetPortalUpVector())) < PORTAL_UP_SIZE_HALF)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool UPortalCharacterMovementComponent::MoveThroughPortalOpenings(
+	const FVector& Delta,
+	const FQuat& NewRotation,
+	bool bSweep,
+	FHitResult* OutHit,
+	ETeleportType Teleport)
+{
+	FHitResult Hit(1.f);
+	auto bMoved = Super::MoveUpdatedComponentImpl(
+		Delta, NewRotation, bSweep, &Hit, Teleport);
+
+	// A wall hit inside an opening is passed by moving the rest of the
+	// way without the wall. It is ignored for this move only, so any
+	// other hit on it is tested again by the next move.
+	TArray<TObjectPtr<UPrimitiveComponent>, TInlineAllocator<PORTAL_MAX_PASSED_SURFACES>> PassedSurfaces;
+	double MovedTime = 0.0;
+
+	while (bSweep &&
+		UpdatedPrimitive &&
+		Hit.bBlockingHit &&
+		PassedSurfaces.Num() < PORTAL_MAX_PASSED_SURFACES &&
+		IsHitInPortalOpening(Hit))
+	{
+		const auto Surface = Hit.GetComponent();
+		PassedSurfaces.Add(Surface);
+		UpdatedPrimitive->IgnoreComponentWhenMoving(Surface, true);
+
+		MovedTime += (1.0 - MovedTime) * Hit.Time;
+
+		Hit = FHitResult(1.f);
+		bMoved |= Super::MoveUpdatedComponentImpl(
+			Delta * (1.0 - MovedTime), NewRotation, bSweep, &Hit, Teleport);
+	}
+
+	for (const auto& Surface : PassedSurfaces)
+	{
+		UpdatedPrimitive->IgnoreComponentWhenMoving(Surface, false);
+	}
+
+	if (Hit.bBlockingHit)
+	{
+		Hit.Time = MovedTime + (1.0 - MovedTime) * Hit.Time;
+	}
+
+	if (OutHit)
+	{
+		*OutHit = Hit;
+	}
+
+	return bMoved;
+}
+
+void UPortalCharacterMovementComponent::TeleportThroughPortal(APortal& Portal)
+{
+	const auto AfterLocation =
+		Portal.TransformPointToDestSpace(
+			UpdatedComponent->GetComponentLocation());
+	const auto AfterQuat =
+		Portal.TransformQuatToDestSpace(
+			UpdatedComponent->GetComponentQuat());
+
+	// character always on the ground straightly, so
+	// rotate character actor by only axis z(yaw)
+	const FRotator AfterRotator(0.0, AfterQuat.Rotator().Yaw, 0.0);
+
+	UpdatedComponent->SetWorldLocationAndRotation(
+		AfterLocation,
+		AfterRotator,
+		false,
+		nullptr,
+		ETeleportType::TeleportPhysics);
+
+	Velocity = Portal.TransformVectorToDestSpace(Velocity);
+
+	if (const auto Controller = CharacterOwner->GetController())
+	{
+		const auto AfterControllerQuat =
+			Portal.TransformQuatToDestSpace(
+				Controller->GetControlRotation().Quaternion());
+		Controller->SetControlRotation(AfterControllerQuat.Rotator());
+	}
+
+	Portal.HandleActorPassed(CharacterOwner);
+}
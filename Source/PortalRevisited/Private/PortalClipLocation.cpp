@@ -3,6 +3,7 @@
 #include "PortalClipLocation.h"
 
 #include "DebugHelper.h"
+#include "PortalDebugOverlay.h"
 #include "Materials/MaterialParameterCollection.h"
 #include "Materials/MaterialParameterCollectionInstance.h"
 #include "PortalRevisited/Portal.h"
@@ -64,15 +65,8 @@ void ClampZeroToOne(UE::Math::TVector4<double>& ClipLeftUp, UE::Math::TVector4<d
 	ClipRightDown.Y = FMath::Clamp(ClipRightDown.Y, 0.0f, 1.0f);
 }
 
-void CalculateClipSpaceLocation(const FMatrix& ViewProjectionMatrix, APortal* PortalToDraw, UE::Math::TVector4<double>& ClipLeftUp, UE::Math::TVector4<double>& ClipLeftDown, UE::Math::TVector4<double>& ClipRightUp, UE::Math::TVector4<double>& ClipRightDown)
+void CalculateClipSpaceLocation(const FMatrix& ViewProjectionMatrix, const FVector& PortalCenter, const FVector& PortalRight, const FVector& PortalUp, UE::Math::TVector4<double>& ClipLeftUp, UE::Math::TVector4<double>& ClipLeftDown, UE::Math::TVector4<double>& ClipRightUp, UE::Math::TVector4<double>& ClipRightDown)
 {
-	const auto PortalCenter = 
-		PortalToDraw->GetPortalPlaneLocation();
-	const auto PortalRight =
-		PortalToDraw->GetPortalRightVector();
-	const auto PortalUp =
-		PortalToDraw->GetPortalUpVector();
-
 	// TODO: Refactor hard coded portal size
 	constexpr double PORTAL_HEIGHT_HALF = 150.0;
 	constexpr double PORTAL_WIDTH_HALF = 100.0;
@@ -123,6 +117,19 @@ void CalculateClipSpaceLocation(const FMatrix& ViewProjectionMatrix, APortal* Po
 	ClampZeroToOne(ClipLeftUp, ClipLeftDown, ClipRightUp, ClipRightDown);
 }
 
+void CalculateClipSpaceLocation(const FMatrix& ViewProjectionMatrix, APortal* PortalToDraw, UE::Math::TVector4<double>& ClipLeftUp, UE::Math::TVector4<double>& ClipLeftDown, UE::Math::TVector4<double>& ClipRightUp, UE::Math::TVector4<double>& ClipRightDown)
+{
+	CalculateClipSpaceLocation(
+		ViewProjectionMatrix,
+		PortalToDraw->GetPortalPlaneLocation(),
+		PortalToDraw->GetPortalRightVector(),
+		PortalToDraw->GetPortalUpVector(),
+		ClipLeftUp,
+		ClipLeftDown,
+		ClipRightUp,
+		ClipRightDown);
+}
+
 void UPortalClipLocation::UpdateBackPortalClipLocation(
 	const FMatrix& ViewProjectionMatrix, 
 	APortal* PortalToDraw)
@@ -142,6 +149,19 @@ void UPortalClipLocation::UpdateBackPortalClipLocation(
 		ClipRightUp, 
 		ClipRightDown);
 
+	if (FPortalDebugOverlay::IsEnabled(EPortalDebugCategory::ClipCorners))
+	{
+		FPortalDebugOverlay::Printf(
+			EPortalDebugCategory::ClipCorners,
+			static_cast<int32>(PortalToDraw->GetUniqueID() * 2),
+			TEXT("Portal %u back: (%.2f, %.2f) (%.2f, %.2f) (%.2f, %.2f) (%.2f, %.2f)"),
+			PortalToDraw->GetUniqueID(),
+			ClipLeftUp.X, ClipLeftUp.Y,
+			ClipLeftDown.X, ClipLeftDown.Y,
+			ClipRightUp.X, ClipRightUp.Y,
+			ClipRightDown.X, ClipRightDown.Y);
+	}
+
 	const auto LeftUpParameterName =
 		PARAMETER_NAME_BACK + PARAMETER_NAME_LEFTUP;
 	
@@ -190,6 +210,19 @@ void UPortalClipLocation::UpdateFrontPortalClipLocation(
 		ClipRightUp, 
 		ClipRightDown);
 
+	if (FPortalDebugOverlay::IsEnabled(EPortalDebugCategory::ClipCorners))
+	{
+		FPortalDebugOverlay::Printf(
+			EPortalDebugCategory::ClipCorners,
+			static_cast<int32>(PortalToDraw->GetUniqueID() * 2 + 1),
+			TEXT("Portal %u front: (%.2f, %.2f) (%.2f, %.2f) (%.2f, %.2f) (%.2f, %.2f)"),
+			PortalToDraw->GetUniqueID(),
+			ClipLeftUp.X, ClipLeftUp.Y,
+			ClipLeftDown.X, ClipLeftDown.Y,
+			ClipRightUp.X, ClipRightUp.Y,
+			ClipRightDown.X, ClipRightDown.Y);
+	}
+
 	const auto LeftUpParameterName =
 		PARAMETER_NAME_FRONT + PARAMETER_NAME_LEFTUP;
 	
@@ -223,6 +256,19 @@ void UPortalClipLocation::UpdateFrontPortalClipLocation(
 bool UPortalClipLocation::CannotSeePortal(
 	const FMatrix& ViewProjectionMatrix, 
 	APortal* PortalToDraw)
+{
+	return CannotSeePortal(
+		ViewProjectionMatrix,
+		PortalToDraw->GetPortalPlaneLocation(),
+		PortalToDraw->GetPortalRightVector(),
+		PortalToDraw->GetPortalUpVector());
+}
+
+bool UPortalClipLocation::CannotSeePortal(
+	const FMatrix& ViewProjectionMatrix,
+	const FVector& PortalCenter,
+	const FVector& PortalRight,
+	const FVector& PortalUp)
 {
 	UE::Math::TVector4<double> ClipLeftUp;
 	UE::Math::TVector4<double> ClipLeftDown;
@@ -230,7 +276,9 @@ bool UPortalClipLocation::CannotSeePortal(
 	UE::Math::TVector4<double> ClipRightDown;
 	CalculateClipSpaceLocation(
 		ViewProjectionMatrix,
-		PortalToDraw, 
+		PortalCenter,
+		PortalRight,
+		PortalUp, 
 		ClipLeftUp, 
 		ClipLeftDown,
 		ClipRightUp, 
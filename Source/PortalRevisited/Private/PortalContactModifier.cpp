@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalContactModifier.h"
+
+#include "Chaos/ContactModification.h"
+#include "Components/PrimitiveComponent.h"
+#include "Chaos/ParticleHandle.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+#include "PortalRevisited/Portal.h"
+
+// Contacts may lie slightly in front of the wall surface, or inside the
+// wall while a body is sinking into the portal.
+constexpr double PORTAL_CONTACT_FRONT_TOLERANCE = 5.0;
+constexpr double PORTAL_CONTACT_BACK_DEPTH = 100.0;
+
+std::optional<FPortalOpening> FPortalOpening::Make(const APortal& Portal)
+{
+	const auto HostSurface = Portal.GetHostSurface();
+	if (!HostSurface)
+	{
+		return std::nullopt;
+	}
+
+	const auto BodyInstance = HostSurface->GetBodyInstance();
+	if (!BodyInstance || !BodyInstance->ActorHandle)
+	{
+		return std::nullopt;
+	}
+
+	FPortalOpening Result;
+	Result.HostSurfaceProxy = BodyInstance->ActorHandle;
+	Result.Location = Portal.GetPortalPlaneLocation();
+	Result.Forward = Portal.GetPortalForwardVector();
+	Result.Right = Portal.GetPortalRightVector();
+	Result.Up = Portal.GetPortalUpVector();
+
+	return Result;
+}
+
+bool FPortalOpening::Contains(const FVector& Point) const
+{
+	const auto PortalToPoint = Point - Location;
+	const auto Distance = PortalToPoint.Dot(Forward);
+
+	if (Distance > PORTAL_CONTACT_FRONT_TOLERANCE ||
+		Distance < -PORTAL_CONTACT_BACK_DEPTH)
+	{
+		return false;
+	}
+
+	return
+		FMath::Abs(PortalToPoint.Dot(Right)) <= PORTAL_RIGHT_SIZE_HALF &&
+		FMath::Abs(PortalToPoint.Dot(Up)) <= PORTAL_UP_SIZE_HALF;
+}
+
+void FPortalContactModifier::OnContactModification_Internal(
+	Chaos::FCollisionContactModifier& Modifier)
+{
+	if (const auto Input = GetConsumerInput_Internal())
+	{
+		Openings = Input->Openings;
+	}
+
+	if (Openings.IsEmpty())
+	{
+		return;
+	}
+
+	for (Chaos::FContactPairModifier& PairModifier : Modifier.GetContacts())
+	{
+		const auto ParticlePair = PairModifier.GetParticlePair();
+
+		for (const auto& Opening : Openings)
+		{
+			const auto bIsHostSurfacePair =
+				ParticlePair[0]->PhysicsProxy() == Opening.HostSurfaceProxy ||
+				ParticlePair[1]->PhysicsProxy() == Opening.HostSurfaceProxy;
+
+			if (!bIsHostSurfacePair)
+			{
+				continue;
+			}
+
+			// A body overlapping the rim of the portal should still
+			// be blocked by the wall.
+			auto bAllContactsInOpening = PairModifier.GetNumContacts() > 0;
+
+			for (int32 ContactIndex = 0;
+				ContactIndex < PairModifier.GetNumContacts();
+				++ContactIndex)
+			{
+				Chaos::FVec3 Location0;
+				Chaos::FVec3 Location1;
+				PairModifier.GetWorldContactLocations(
+					ContactIndex,
+					Location0,
+					Location1);
+
+				if (!Opening.Contains(Location0) || !Opening.Contains(Location1))
+				{
+					bAllContactsInOpening = false;
+					break;
+				}
+			}
+
+			if (bAllContactsInOpening)
+			{
+				PairModifier.Disable();
+				break;
+			}
+		}
+	}
+}
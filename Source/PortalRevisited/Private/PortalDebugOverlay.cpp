@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalDebugOverlay.h"
+
+// The overlay is for development only, so shipping builds
+// keep neither its console variables nor its drawing.
+#if !UE_BUILD_SHIPPING
+
+#include "CanvasTypes.h"
+#include "Debug/DebugDrawService.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "Engine/Font.h"
+#include "HAL/IConsoleManager.h"
+
+// A keyed line is rewritten every frame while it is shown,
+// so it disappears soon after it stops.
+constexpr double PORTAL_DEBUG_KEYED_SECONDS = 0.5;
+constexpr double PORTAL_DEBUG_RING_SECONDS = 5.0;
+constexpr float PORTAL_DEBUG_LEFT = 16.f;
+constexpr float PORTAL_DEBUG_TOP = 96.f;
+
+static bool GPortalDebugCategories[static_cast<int32>(EPortalDebugCategory::Num)] =
+{
+	true,
+	false,
+	false,
+	false
+};
+
+static FAutoConsoleVariableRef CVarPortalDebugGeneral(
+	TEXT("portal.Debug.General"),
+	GPortalDebugCategories[static_cast<int32>(EPortalDebugCategory::General)],
+	TEXT("Show the on-screen text of DebugHelper."));
+
+static FAutoConsoleVariableRef CVarPortalDebugFrames(
+	TEXT("portal.Debug.Frames"),
+	GPortalDebugCategories[static_cast<int32>(EPortalDebugCategory::Frames)],
+	TEXT("Show the location and forward vector of every linked portal."));
+
+static FAutoConsoleVariableRef CVarPortalDebugClipCorners(
+	TEXT("portal.Debug.ClipCorners"),
+	GPortalDebugCategories[static_cast<int32>(EPortalDebugCategory::ClipCorners)],
+	TEXT("Show the screen corners of the recursive portals."));
+
+static FAutoConsoleVariableRef CVarPortalDebugClones(
+	TEXT("portal.Debug.Clones"),
+	GPortalDebugCategories[static_cast<int32>(EPortalDebugCategory::Clones)],
+	TEXT("Show the transform of every clone."));
+
+static const FLinearColor PORTAL_DEBUG_COLORS[] =
+{
+	FLinearColor::Red,
+	FLinearColor(0.f, 1.f, 1.f),
+	FLinearColor::Yellow,
+	FLinearColor::Green
+};
+static_assert(
+	UE_ARRAY_COUNT(PORTAL_DEBUG_COLORS) == static_cast<int32>(EPortalDebugCategory::Num),
+	"Every debug category has its color.");
+
+static FPortalDebugOverlay* GPortalDebugOverlay = nullptr;
+
+bool FPortalDebugOverlay::IsEnabled(EPortalDebugCategory Category)
+{
+	return GPortalDebugCategories[static_cast<int32>(Category)];
+}
+
+void FPortalDebugOverlay::Shutdown()
+{
+	delete GPortalDebugOverlay;
+	GPortalDebugOverlay = nullptr;
+}
+
+FPortalDebugOverlay::FPortalDebugOverlay()
+	: NextRingIndex(0)
+{
+	DrawHandle = UDebugDrawService::Register(
+		TEXT("Game"),
+		FDebugDrawDelegate::CreateStatic(&FPortalDebugOverlay::Draw));
+}
+
+FPortalDebugOverlay::~FPortalDebugOverlay()
+{
+	UDebugDrawService::Unregister(DrawHandle);
+}
+
+FPortalDebugOverlay& FPortalDebugOverlay::Get()
+{
+	// Created on the first line, so nothing is drawn before.
+	if (!GPortalDebugOverlay)
+	{
+		GPortalDebugOverlay = new FPortalDebugOverlay();
+	}
+
+	return *GPortalDebugOverlay;
+}
+
+void FPortalDebugOverlay::Draw(UCanvas* Canvas, APlayerController* PlayerController)
+{
+	if (!Canvas || !Canvas->Canvas)
+		return;
+
+	Get().DrawLines(*Canvas);
+}
+
+TCHAR* FPortalDebugOverlay::AcquireLine(EPortalDebugCategory Category, int32 Key)
+{
+	const auto Now = FPlatformTime::Seconds();
+
+	if (Key == NO_KEY)
+	{
+		auto& Line = RingLines[NextRingIndex];
+		NextRingIndex = (NextRingIndex + 1) % RING_SLOTS;
+
+		Line.Category = Category;
+		Line.ExpireSeconds = Now + PORTAL_DEBUG_RING_SECONDS;
+		return Line.Text;
+	}
+
+	// The slot of the key, or else an expired slot, or else the
+	// slot which expires first.
+	FLine* Slot = &KeyedLines[0];
+	for (auto& Line : KeyedLines)
+	{
+		if (Line.Key == Key && Line.Category == Category)
+		{
+			Slot = &Line;
+			break;
+		}
+
+		if (Line.ExpireSeconds < Slot->ExpireSeconds)
+		{
+			Slot = &Line;
+		}
+	}
+
+	Slot->Key = Key;
+	Slot->Category = Category;
+	Slot->ExpireSeconds = Now + PORTAL_DEBUG_KEYED_SECONDS;
+	return Slot->Text;
+}
+
+void FPortalDebugOverlay::DrawLines(UCanvas& Canvas) const
+{
+	const auto Font = GEngine->GetSmallFont();
+	const auto LineHeight = Font->GetMaxCharHeight();
+	const auto Now = FPlatformTime::Seconds();
+
+	auto Y = PORTAL_DEBUG_TOP;
+
+	const auto DrawLine = [&](const FLine& Line)
+	{
+		if (Line.ExpireSeconds < Now || !IsEnabled(Line.Category))
+			return;
+
+		Canvas.Canvas->DrawShadowedString(
+			PORTAL_DEBUG_LEFT,
+			Y,
+			Line.Text,
+			Font,
+			PORTAL_DEBUG_COLORS[static_cast<int32>(Line.Category)]);
+		Y += LineHeight;
+	};
+
+	for (const auto& Line : KeyedLines)
+	{
+		DrawLine(Line);
+	}
+
+	// The newest line of the ring first.
+	for (int32 i = 1; i <= RING_SLOTS; ++i)
+	{
+		DrawLine(RingLines[(NextRingIndex - i + RING_SLOTS) % RING_SLOTS]);
+	}
+}
+
+#endif
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalGrabController.h"
+
+#include "Chaos/ParticleHandle.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+#include "PortalRevisited/Portal.h"
+
+void FPortalGrabController::OnPreSimulate_Internal()
+{
+	if (const auto Input = GetConsumerInput_Internal())
+	{
+		// A stop is always taken, even of the canceled grab.
+		if (!Input->Proxy || Input->GrabId != CanceledGrabId)
+		{
+			Grab = *Input;
+		}
+	}
+
+	if (!Grab.Proxy)
+	{
+		return;
+	}
+
+	const auto Handle = Grab.Proxy->GetPhysicsThreadAPI();
+	if (!Handle)
+	{
+		return;
+	}
+
+	// A body held still at the target falls asleep, and a sleeping
+	// body ignores the velocity.
+	if (Handle->ObjectState() == Chaos::EObjectStateType::Sleeping)
+	{
+		Handle->SetObjectState(Chaos::EObjectStateType::Dynamic);
+	}
+
+	if (Handle->ObjectState() != Chaos::EObjectStateType::Dynamic)
+	{
+		return;
+	}
+
+	const FVector Location = Handle->X();
+
+	const std::optional<FVector> Direct = Grab.TargetLocation;
+	const auto ThroughPortal = GetTargetThroughPortal();
+
+	auto Target = Grab.bAcrossedPortal ? ThroughPortal : Direct;
+	const auto& Fallback = Grab.bAcrossedPortal ? Direct : ThroughPortal;
+
+	// The body passed the portal on the physics thread, and the
+	// game thread has not been told yet.
+	if (!IsInReach(Location, Target) && IsInReach(Location, Fallback))
+	{
+		Target = Fallback;
+	}
+
+	// Too far, or on the other side while the portal is out of view.
+	if (!IsInReach(Location, Target))
+	{
+		Cancel();
+		return;
+	}
+
+	Handle->SetV((*Target - Location) * Grab.VelocityMultiplier);
+	Handle->SetW(FVector(0.0));
+}
+
+std::optional<FVector> FPortalGrabController::GetTargetThroughPortal() const
+{
+	if (!Grab.bHasPortals)
+	{
+		return std::nullopt;
+	}
+
+	for (const auto bAtFirst : { true, false })
+	{
+		const auto& Src = bAtFirst ? Grab.First : Grab.Second;
+		const auto& Dest = bAtFirst ? Grab.Second : Grab.First;
+
+		const auto bIsPortalInView =
+			APortal::DoesSegmentCrossPortal(
+				Grab.ViewStart,
+				Grab.ViewEnd,
+				Src.PlaneLocation,
+				Src.Forward,
+				Src.Right,
+				Src.Up);
+
+		if (bIsPortalInView)
+		{
+			return Src.TransformPointTo(Dest, Grab.TargetLocation);
+		}
+	}
+
+	return std::nullopt;
+}
+
+bool FPortalGrabController::IsInReach(
+	const FVector& Location,
+	const std::optional<FVector>& Target) const
+{
+	return Target &&
+		FVector::DistSquared(Location, *Target) <= FMath::Square(Grab.MaxDistance);
+}
+
+void FPortalGrabController::Cancel()
+{
+	CanceledGrabId = Grab.GrabId;
+	GetProducerOutputData_Internal()->CanceledGrabId = Grab.GrabId;
+	Grab.Reset();
+}
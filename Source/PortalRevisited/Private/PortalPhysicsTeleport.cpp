@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalPhysicsTeleport.h"
+
+#include "Chaos/ParticleHandle.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+#include "PortalRevisited/Portal.h"
+
+void FPortalPhysicsTeleport::OnPreSimulate_Internal()
+{
+	if (const auto Input = GetConsumerInput_Internal())
+	{
+		First = Input->First;
+		Second = Input->Second;
+		Bodies = Input->Bodies;
+	}
+
+	if (Bodies.IsEmpty())
+	{
+		return;
+	}
+
+	const auto DeltaTime = GetDeltaTime_Internal();
+	auto Output = GetProducerOutputData_Internal();
+
+	// Iterate backward, because teleported bodies are removed.
+	for (int32 i = Bodies.Num() - 1; i >= 0; --i)
+	{
+		const auto& Body = Bodies[i];
+
+		const auto Handle = Body.Proxy->GetPhysicsThreadAPI();
+		if (!Handle || Handle->ObjectState() != Chaos::EObjectStateType::Dynamic)
+		{
+			continue;
+		}
+
+		const auto& Src = Body.bAtFirst ? First : Second;
+		const auto& Dest = Body.bAtFirst ? Second : First;
+
+		const FVector Location = Handle->X();
+		const FVector Velocity = Handle->V();
+
+		const auto bWillCrossPortal =
+			APortal::DoesSegmentCrossPortal(
+				Location,
+				Location + Velocity * DeltaTime,
+				Src.PlaneLocation,
+				Src.Forward,
+				Src.Right,
+				Src.Up);
+
+		if (!bWillCrossPortal)
+		{
+			continue;
+		}
+
+		Handle->SetX(Src.TransformPointTo(Dest, Location));
+		Handle->SetR(Src.TransformQuatTo(Dest, FQuat(Handle->R())));
+		Handle->SetV(Src.TransformVectorTo(Dest, Velocity));
+		Handle->SetW(Src.TransformVectorTo(Dest, FVector(Handle->W())));
+
+		Output->TeleportedBodies.Add(Body);
+
+		// The game thread sends the body again once it
+		// is tracked by the other portal.
+		Bodies.RemoveAtSwap(i, 1, false);
+	}
+}
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalPlacementBenchmarkCommandlet.h"
+
+#include "PortalRevisited/Portal.h"
+
+constexpr int32 PORTAL_BENCHMARK_DEFAULT_ITERATIONS = 100000;
+constexpr int32 PORTAL_BENCHMARK_DEFAULT_SEED = 0;
+// Walls are from smaller than the portal to much larger.
+constexpr float PORTAL_BENCHMARK_MIN_HALF_SIZE = 50.f;
+constexpr float PORTAL_BENCHMARK_MAX_HALF_SIZE = 1000.f;
+constexpr float PORTAL_BENCHMARK_WALL_HALF_THICKNESS = 10.f;
+constexpr float PORTAL_BENCHMARK_WORLD_HALF_SIZE = 10000.f;
+constexpr float PORTAL_BENCHMARK_TOLERANCE = 0.01f;
+// How many broken placements are logged in detail.
+constexpr int32 PORTAL_BENCHMARK_MAX_LOGGED_VIOLATIONS = 10;
+
+UPortalPlacementBenchmarkCommandlet::UPortalPlacementBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPortalPlacementBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 Iterations = PORTAL_BENCHMARK_DEFAULT_ITERATIONS;
+	int32 Seed = PORTAL_BENCHMARK_DEFAULT_SEED;
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	if (Iterations <= 0)
+	{
+		UE_LOG(Portal, Error, TEXT("Iterations should be positive: %d"), Iterations);
+		return 1;
+	}
+
+	FRandomStream Random(Seed);
+
+	// Generated first, so only the solver is timed.
+	TArray<FPortalPlacementInput> Inputs;
+	Inputs.Reserve(Iterations);
+	for (int32 i = 0; i < Iterations; ++i)
+	{
+		Inputs.Add(MakeRandomInput(Random));
+	}
+
+	TArray<std::optional<FPortalPlacement>> Placements;
+	Placements.SetNum(Iterations);
+
+	const auto StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; ++i)
+	{
+		Placements[i] = FPortalPlacementSolver::Solve(Inputs[i]);
+	}
+	const auto ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 NumPlaced = 0;
+	TMap<FString, int32> Violations;
+
+	for (int32 i = 0; i < Iterations; ++i)
+	{
+		if (!Placements[i])
+			continue;
+
+		++NumPlaced;
+
+		const auto Violation = CheckPlacement(Inputs[i], *Placements[i]);
+		if (!Violation)
+			continue;
+
+		auto& NumViolations = Violations.FindOrAdd(Violation);
+		if (NumViolations++ < PORTAL_BENCHMARK_MAX_LOGGED_VIOLATIONS)
+		{
+			UE_LOG(Portal, Warning, TEXT("Placement %d breaks \"%s\": impact %s, normal %s, result %s %s"),
+				i,
+				Violation,
+				*Inputs[i].ImpactPoint.ToString(),
+				*Inputs[i].ImpactNormal.ToString(),
+				*Placements[i]->Location.ToString(),
+				*Placements[i]->Rotation.ToString());
+		}
+	}
+
+	UE_LOG(Portal, Display, TEXT("Solved %d placements in %.3f ms: %.0f solves/s"),
+		Iterations,
+		ElapsedTime * 1000.0,
+		ElapsedTime > 0.0 ? Iterations / ElapsedTime : 0.0);
+	UE_LOG(Portal, Display, TEXT("Placed %d, rejected %d"), NumPlaced, Iterations - NumPlaced);
+
+	for (const auto& [Violation, NumViolations] : Violations)
+	{
+		UE_LOG(Portal, Error, TEXT("%d placements break \"%s\""), NumViolations, *Violation);
+	}
+
+	return Violations.IsEmpty() ? 0 : 1;
+}
+
+FPortalPlacementInput UPortalPlacementBenchmarkCommandlet::MakeRandomInput(FRandomStream& Random)
+{
+	FPortalPlacementInput Input;
+
+	const auto HalfRight = Random.FRandRange(
+		PORTAL_BENCHMARK_MIN_HALF_SIZE, PORTAL_BENCHMARK_MAX_HALF_SIZE);
+	const auto HalfUp = Random.FRandRange(
+		PORTAL_BENCHMARK_MIN_HALF_SIZE, PORTAL_BENCHMARK_MAX_HALF_SIZE);
+	const auto Center = Random.GetUnitVector() *
+		Random.FRandRange(0.f, PORTAL_BENCHMARK_WORLD_HALF_SIZE);
+
+	FVector Normal;
+	FVector Right;
+
+	if (Random.FRand() < 0.5f)
+	{
+		// A wall, a floor or a ceiling on the world axes.
+		const auto Axis = Random.RandRange(0, 2);
+		const auto Sign = Random.FRand() < 0.5f ? 1.0 : -1.0;
+
+		Normal = FVector(0.0);
+		Normal[Axis] = Sign;
+		Right = FVector(0.0);
+		Right[(Axis + 1) % 3] = 1.0;
+	}
+	else
+	{
+		// A rotated or slanted surface.
+		Normal = Random.GetUnitVector();
+
+		FVector UnusedAxis;
+		Normal.FindBestAxisVectors(Right, UnusedAxis);
+		Right = FQuat(Normal, Random.FRandRange(0.f, UE_TWO_PI)).RotateVector(Right);
+	}
+
+	const auto Up = FVector::CrossProduct(Normal, Right);
+
+	Input.ImpactPoint = Center +
+		Right * Random.FRandRange(-HalfRight, HalfRight) +
+		Up * Random.FRandRange(-HalfUp, HalfUp);
+	Input.ImpactNormal = Normal;
+	Input.PortalQuat = FRotator(
+		Random.FRandRange(-180.f, 180.f),
+		Random.FRandRange(-180.f, 180.f),
+		Random.FRandRange(-180.f, 180.f)).Quaternion();
+	Input.CharacterForward =
+		FRotator(0.f, Random.FRandRange(-180.f, 180.f), 0.f).Vector();
+
+	const auto bIsAxisAligned =
+		FMath::Abs(Normal.X) == 1.0 ||
+		FMath::Abs(Normal.Y) == 1.0 ||
+		FMath::Abs(Normal.Z) == 1.0;
+
+	if (bIsAxisAligned && Random.FRand() < 0.5f)
+	{
+		// The surface is the face of a wall box.
+		const auto WallCenter = Center - Normal * PORTAL_BENCHMARK_WALL_HALF_THICKNESS;
+		const auto WallExtent =
+			(Right * HalfRight + Up * HalfUp + Normal * PORTAL_BENCHMARK_WALL_HALF_THICKNESS).GetAbs();
+
+		Input.SurfaceCenter = WallCenter;
+		Input.SurfaceExtent = WallExtent;
+	}
+	else
+	{
+		FPortalSurfaceRect Rect;
+		Rect.Center = FVector3f(Center);
+		Rect.Normal = FVector3f(Normal);
+		Rect.Right = FVector3f(Right);
+		Rect.Up = FVector3f(Up);
+		Rect.HalfRight = HalfRight;
+		Rect.HalfUp = HalfUp;
+
+		Input.SurfaceRect = Rect;
+	}
+
+	return Input;
+}
+
+const TCHAR* UPortalPlacementBenchmarkCommandlet::CheckPlacement(
+	const FPortalPlacementInput& Input,
+	const FPortalPlacement& Placement)
+{
+	const auto& Rotation = Placement.Rotation;
+
+	if (Placement.Location.ContainsNaN() || Rotation.ContainsNaN())
+	{
+		return TEXT("no NaN");
+	}
+
+	if (!Rotation.IsNormalized())
+	{
+		return TEXT("normalized rotation");
+	}
+
+	const auto PortalForward = Rotation.GetForwardVector();
+	const auto PortalRight = Rotation.GetRightVector();
+	const auto PortalUp = Rotation.GetUpVector();
+
+	if (PortalForward.Dot(Input.ImpactNormal) < 1.0 - PORTAL_BENCHMARK_TOLERANCE)
+	{
+		return TEXT("faces the impact normal");
+	}
+
+	for (const auto RightSign : { 1.0, -1.0 })
+	{
+		for (const auto UpSign : { 1.0, -1.0 })
+		{
+			const auto Corner = Placement.Location +
+				PortalRight * PORTAL_RIGHT_SIZE_HALF * RightSign +
+				PortalUp * PORTAL_UP_SIZE_HALF * UpSign;
+
+			if (Input.SurfaceRect)
+			{
+				const auto& Rect = *Input.SurfaceRect;
+				const auto CenterToCorner = Corner - FVector(Rect.Center);
+
+				if (FMath::Abs(CenterToCorner.Dot(FVector(Rect.Right))) > Rect.HalfRight + PORTAL_BENCHMARK_TOLERANCE ||
+					FMath::Abs(CenterToCorner.Dot(FVector(Rect.Up))) > Rect.HalfUp + PORTAL_BENCHMARK_TOLERANCE)
+				{
+					return TEXT("inside the rectangle");
+				}
+			}
+			else
+			{
+				const auto Bounds = FBox(
+					Input.SurfaceCenter - Input.SurfaceExtent,
+					Input.SurfaceCenter + Input.SurfaceExtent);
+
+				if (!Bounds.ExpandBy(PORTAL_BENCHMARK_TOLERANCE).IsInsideOrOn(Corner))
+				{
+					return TEXT("inside the bounds");
+				}
+			}
+		}
+	}
+
+	return nullptr;
+}
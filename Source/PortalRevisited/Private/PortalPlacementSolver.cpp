@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalPlacementSolver.h"
+
+#include "PortalRevisited/Portal.h"
+#include "PortalStats.h"
+
+constexpr float PORTAL_FORWARD_OFFSET = 3.0f;
+
+std::optional<FPortalPlacement> FPortalPlacementSolver::Solve(
+	const FPortalPlacementInput& Input)
+{
+	PORTAL_SCOPE_CYCLE_COUNTER(SolvePlacement);
+
+	FVector ResultPoint = Input.ImpactPoint -
+		PORTAL_FORWARD_OFFSET * Input.ImpactNormal;
+
+	const auto PortalRotation = CalculatePortalRotation(Input);
+
+	const auto PortalUp = PortalRotation.GetUpVector();
+	const auto PortalRight = PortalRotation.GetRightVector();
+
+	if (Input.SurfaceRect)
+	{
+		// Move the portal into the rectangle along its axes.
+		const auto& Rect = *Input.SurfaceRect;
+		const auto RectCenter = FVector(Rect.Center);
+
+		for (const auto& [U, HalfSize] : {
+			TPair<FVector, double>(FVector(Rect.Right), Rect.HalfRight),
+			TPair<FVector, double>(FVector(Rect.Up), Rect.HalfUp) })
+		{
+			const auto PortalOffset = MovePortalUAxisAligned(
+				RectCenter.Dot(U),
+				HalfSize,
+				PortalRight,
+				PortalUp,
+				ResultPoint,
+				U);
+
+			if (!PortalOffset)
+			{
+				return std::nullopt;
+			}
+
+			ResultPoint += *PortalOffset;
+		}
+	}
+	else
+	{
+		// Move the portal into the bounds along each world axis.
+		for (const auto& U : { FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector })
+		{
+			const auto PortalOffset = MovePortalUAxisAligned(
+				Input.SurfaceCenter.Dot(U),
+				Input.SurfaceExtent.Dot(U),
+				PortalRight,
+				PortalUp,
+				ResultPoint,
+				U);
+
+			if (!PortalOffset)
+			{
+				return std::nullopt;
+			}
+
+			ResultPoint += *PortalOffset;
+		}
+	}
+
+	return FPortalPlacement{ ResultPoint, PortalRotation };
+}
+
+FQuat FPortalPlacementSolver::CalculatePortalRotation(const FPortalPlacementInput& Input)
+{
+	const auto& ImpactNormal = Input.ImpactNormal;
+	FQuat Result;
+
+	{
+		const auto PortalForward =
+			Input.PortalQuat.GetForwardVector();
+		const auto OldQuat = PortalForward.ToOrientationQuat();
+		const auto NewQuat = ImpactNormal.ToOrientationQuat();
+
+		const auto DiffQuat = NewQuat * OldQuat.Inverse();
+		Result = DiffQuat * Input.PortalQuat;
+	}
+
+	// The result calculated before is only correctly for
+	// forward vector, but to rotate correctly for up vector
+	// or right vector, correct with WorldZ.
+	const auto WorldZ = FVector(0.0f, 0.0f, 1.0f);
+
+	if (ImpactNormal.Equals(WorldZ) || ImpactNormal.Equals(-WorldZ))
+	{
+		const auto PortalUp = Result.GetUpVector();
+
+		const auto& TargetPortalUp = Input.CharacterForward;
+
+		const auto RotateAxis =
+			PortalUp.Cross(TargetPortalUp).GetSafeNormal();
+		const auto CosTheta = PortalUp.Dot(TargetPortalUp);
+
+		const auto ThetaRadian = FMath::Acos(CosTheta);
+
+		Result = FQuat(RotateAxis, ThetaRadian) * Result;
+	}
+	else
+	{
+		const auto PortalRight = Result.GetRightVector();
+
+		const FVector TargetPortalRight =
+			FVector::CrossProduct(WorldZ, ImpactNormal).GetSafeNormal();
+
+		FVector RotateAxis;
+		if (!PortalRight.Equals(TargetPortalRight))
+		{
+			RotateAxis =
+				PortalRight.Cross(TargetPortalRight).GetSafeNormal();
+			const auto CosTheta = PortalRight.Dot(TargetPortalRight);
+			const auto ThetaRadian = FMath::Acos(CosTheta);
+
+			Result = FQuat(RotateAxis, ThetaRadian) * Result;
+		}
+	}
+
+	return Result;
+}
+
+std::optional<FVector> FPortalPlacementSolver::MovePortalUAxisAligned(
+	double BoundCenterU,
+	double BoundExtentU,
+	const FVector& PortalRight,
+	const FVector& PortalUp,
+	const FVector& PortalCenter,
+	const FVector& U)
+{
+	// Calculate boundary of U coordinate.
+	const auto UMax = FMath::Max(
+		BoundCenterU + BoundExtentU,
+		BoundCenterU - BoundExtentU);
+	const auto UMin = FMath::Min(
+		BoundCenterU + BoundExtentU,
+		BoundCenterU - BoundExtentU);
+
+	const auto PortalUpDotU = PortalUp.Dot(U);
+	const auto PortalRightDotU = PortalRight.Dot(U);
+
+	const auto PortalUSizeHalf =
+		PORTAL_UP_SIZE_HALF * FMath::Abs(PortalUpDotU) +
+		PORTAL_RIGHT_SIZE_HALF * FMath::Abs(PortalRightDotU);
+
+	// Portal.U should be in the boundary:
+	// PortalUMin <= Portal.U < PortalUMax
+	const auto PortalUMax = UMax - PortalUSizeHalf;
+	const auto PortalUMin = UMin + PortalUSizeHalf;
+
+	if (PortalUMax < PortalUMin)
+	{
+		// Impossible.
+		return std::nullopt;
+	}
+
+	const auto CenterDotU = PortalCenter.Dot(U);
+	double Delta = 0.0;
+
+	// Should move portal to +U?
+	if (CenterDotU < PortalUMin)
+	{
+		Delta = PortalUMin - CenterDotU;
+	}
+	else if (CenterDotU > PortalUMax)
+	{
+		Delta = PortalUMax - CenterDotU;
+	}
+
+	return Delta * U;
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalProjectileMovementComponent.h"
+
+#include "PortalSubsystem.h"
+#include "PortalRevisited/Portal.h"
+
+// How far in front of the exited portal the projectile should be
+// before the wall the portal is placed on blocks it again.
+constexpr double PORTAL_PROJECTILE_EXIT_MARGIN = 10.0;
+
+UPortalProjectileMovementComponent::UPortalProjectileMovementComponent()
+	: bPassesPortals(true)
+	, bIsMovingThroughPortal(false)
+{
+}
+
+bool UPortalProjectileMovementComponent::HandlesPortalTraversal(const AActor& Actor)
+{
+	const auto Movement =
+		Actor.FindComponentByClass<UPortalProjectileMovementComponent>();
+
+	return Movement && Movement->bPassesPortals;
+}
+
+void UPortalProjectileMovementComponent::StopMovementImmediately()
+{
+	Super::StopMovementImmediately();
+
+	// A pooled projectile is launched again from anywhere.
+	SetIgnoredSurface(nullptr);
+	ExitedPortal = nullptr;
+}
+
+bool UPortalProjectileMovementComponent::MoveUpdatedComponentImpl(
+	const FVector& Delta,
+	const FQuat& NewRotation,
+	bool bSweep,
+	FHitResult* OutHit,
+	ETeleportType Teleport)
+{
+	if (bIsMovingThroughPortal || !bPassesPortals || !UpdatedComponent)
+	{
+		return Super::MoveUpdatedComponentImpl(
+			Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	UpdateIgnoredSurface();
+
+	const auto World = GetWorld();
+	const auto PortalSubsystem =
+		World ? World->GetSubsystem<UPortalSubsystem>() : nullptr;
+	if (!PortalSubsystem)
+	{
+		return Super::MoveUpdatedComponentImpl(
+			Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	const auto Start = UpdatedComponent->GetComponentLocation();
+	const auto CrossingOpt =
+		PortalSubsystem->FindPortalCrossing(Start, Start + Delta);
+	if (!CrossingOpt)
+	{
+		return Super::MoveUpdatedComponentImpl(
+			Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	const auto& Crossing = *CrossingOpt;
+	TGuardValue<bool> MovingThroughPortalGuard(bIsMovingThroughPortal, true);
+
+	// Move until the portal plane, through the wall the portal is on.
+	SetIgnoredSurface(Crossing.Portal->GetHostSurface());
+
+	FHitResult Hit(1.f);
+	const auto bMovedToPortal = Super::MoveUpdatedComponentImpl(
+		Delta * Crossing.Time, NewRotation, bSweep, &Hit, Teleport);
+
+	if (Hit.bBlockingHit)
+	{
+		Hit.Time *= Crossing.Time;
+		if (OutHit)
+		{
+			*OutHit = Hit;
+		}
+		return bMovedToPortal;
+	}
+
+	const auto& Src = Crossing.Src;
+	const auto& Dest = Crossing.Dest;
+
+	UpdatedComponent->SetWorldLocationAndRotation(
+		Src.TransformPointTo(Dest, UpdatedComponent->GetComponentLocation()),
+		Src.TransformQuatTo(Dest, UpdatedComponent->GetComponentQuat()),
+		false,
+		nullptr,
+		ETeleportType::TeleportPhysics);
+
+	Velocity = Src.TransformVectorTo(Dest, Velocity);
+
+	// Leave the linked portal out of the wall it is placed on.
+	ExitedPortal = Crossing.DestPortal;
+	SetIgnoredSurface(ExitedPortal->GetHostSurface());
+
+	const auto bMovedFromPortal = Super::MoveUpdatedComponentImpl(
+		Src.TransformVectorTo(Dest, Delta * (1.0 - Crossing.Time)),
+		UpdatedComponent->GetComponentQuat(),
+		bSweep,
+		&Hit,
+		Teleport);
+
+	if (Hit.bBlockingHit)
+	{
+		Hit.Time = Crossing.Time + (1.0 - Crossing.Time) * Hit.Time;
+	}
+
+	if (OutHit)
+	{
+		*OutHit = Hit;
+	}
+
+	return bMovedToPortal || bMovedFromPortal;
+}
+
+void UPortalProjectileMovementComponent::SetIgnoredSurface(UPrimitiveComponent* Surface)
+{
+	if (Surface == IgnoredSurface)
+		return;
+
+	if (UpdatedPrimitive && IgnoredSurface)
+	{
+		UpdatedPrimitive->IgnoreComponentWhenMoving(IgnoredSurface, false);
+	}
+
+	IgnoredSurface = Surface;
+
+	if (UpdatedPrimitive && IgnoredSurface)
+	{
+		UpdatedPrimitive->IgnoreComponentWhenMoving(IgnoredSurface, true);
+	}
+}
+
+void UPortalProjectileMovementComponent::UpdateIgnoredSurface()
+{
+	if (!IgnoredSurface)
+		return;
+
+	if (ExitedPortal && ExitedPortal->IsActivated())
+	{
+		const auto Distance =
+			(UpdatedComponent->GetComponentLocation() -
+				ExitedPortal->GetPortalPlaneLocation())
+			.Dot(ExitedPortal->GetPortalForwardVector());
+
+		if (Distance < PORTAL_PROJECTILE_EXIT_MARGIN)
+			return;
+	}
+
+	SetIgnoredSurface(nullptr);
+	ExitedPortal = nullptr;
+}
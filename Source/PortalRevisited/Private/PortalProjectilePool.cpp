@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalProjectilePool.h"
+
+#include "PortalRevisited/Portal.h"
+#include "PortalRevisited/PortalRevisitedProjectile.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+constexpr int32 PORTAL_PROJECTILE_POOL_SIZE = 4;
+
+void FPortalProjectilePool::CreateActors(
+	UWorld& World,
+	TSubclassOf<APortalRevisitedProjectile> ProjectileClass)
+{
+	FActorSpawnParameters ActorSpawnParams;
+	ActorSpawnParams.SpawnCollisionHandlingOverride =
+		ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for (int32 i = 0; i < PORTAL_PROJECTILE_POOL_SIZE; ++i)
+	{
+		const auto Projectile = World.SpawnActor<APortalRevisitedProjectile>(
+			ProjectileClass,
+			FVector::ZeroVector,
+			FRotator::ZeroRotator,
+			ActorSpawnParams);
+
+		if (!Projectile)
+			continue;
+
+		Projectile->Release();
+		Actors.Add(Projectile);
+	}
+}
+
+void FPortalProjectilePool::CreateInstances(
+	AActor& Owner,
+	UStaticMesh* Mesh,
+	const FVector& Scale,
+	float Speed)
+{
+	Instances = NewObject<UInstancedStaticMeshComponent>(&Owner, TEXT("PortalProjectileInstances"));
+	Instances->SetStaticMesh(Mesh);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(false);
+	// Instances are placed in the world, not around the owner.
+	Instances->SetUsingAbsoluteLocation(true);
+	Instances->SetUsingAbsoluteRotation(true);
+	Instances->SetUsingAbsoluteScale(true);
+	Instances->RegisterComponent();
+
+	InstanceScale = Scale;
+	InstanceSpeed = Speed;
+
+	// Unused instances are scaled to zero.
+	InstancedProjectiles.SetNum(PORTAL_PROJECTILE_POOL_SIZE);
+	InstanceTransforms.Init(
+		FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector),
+		PORTAL_PROJECTILE_POOL_SIZE);
+
+	for (const auto& Transform : InstanceTransforms)
+	{
+		Instances->AddInstance(Transform, true);
+	}
+}
+
+void FPortalProjectilePool::Destroy()
+{
+	for (const auto& Projectile : Actors)
+	{
+		if (Projectile)
+		{
+			Projectile->Destroy();
+		}
+	}
+	Actors.Empty();
+
+	if (Instances)
+	{
+		Instances->DestroyComponent();
+		Instances = nullptr;
+	}
+	InstancedProjectiles.Empty();
+	InstanceTransforms.Empty();
+}
+
+void FPortalProjectilePool::Fire(
+	const FVector& Location,
+	const FRotator& Rotation,
+	const FVector& Destination)
+{
+	if (Instances)
+	{
+		// The oldest one is reused.
+		auto& Projectile = InstancedProjectiles[NextIndex];
+		NextIndex = (NextIndex + 1) % InstancedProjectiles.Num();
+
+		Projectile.Start = Location;
+		Projectile.Destination = Destination;
+		Projectile.Rotation = Rotation.Quaternion();
+		Projectile.Elapsed = 0.f;
+		Projectile.Duration = FMath::Min(
+			InstanceSpeed > 0.f ? FVector::Dist(Location, Destination) / InstanceSpeed : 0.f,
+			PORTAL_PROJECTILE_LIFE_SPAN);
+		Projectile.bIsInUse = true;
+		return;
+	}
+
+	if (Actors.IsEmpty())
+	{
+		return;
+	}
+
+	// The oldest one is reused.
+	const auto& Projectile = Actors[NextIndex];
+	NextIndex = (NextIndex + 1) % Actors.Num();
+
+	Projectile->Launch(Location, Rotation, Destination);
+}
+
+void FPortalProjectilePool::Tick(float DeltaTime)
+{
+	if (!Instances)
+	{
+		return;
+	}
+
+	bool bIsChanged = false;
+
+	for (int32 i = 0; i < InstancedProjectiles.Num(); ++i)
+	{
+		auto& Projectile = InstancedProjectiles[i];
+		if (!Projectile.bIsInUse)
+			continue;
+
+		bIsChanged = true;
+		Projectile.Elapsed += DeltaTime;
+
+		if (Projectile.Elapsed >= Projectile.Duration)
+		{
+			Projectile.bIsInUse = false;
+			InstanceTransforms[i].SetScale3D(FVector::ZeroVector);
+			continue;
+		}
+
+		const auto Alpha = Projectile.Elapsed / Projectile.Duration;
+		InstanceTransforms[i] = FTransform(
+			Projectile.Rotation,
+			FMath::Lerp(Projectile.Start, Projectile.Destination, Alpha),
+			InstanceScale);
+	}
+
+	if (bIsChanged)
+	{
+		Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+}
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalRayQuery.h"
+
+#include "PortalRevisited/Portal.h"
+
+void FPortalQuads::Reset()
+{
+	Blocks.Reset();
+	NumQuads = 0;
+}
+
+int32 FPortalQuads::Add(const FPortalFrame& Frame)
+{
+	const auto Lane = NumQuads % LANES;
+	if (Lane == 0)
+	{
+		// A zero forward axis never passes the front side test.
+		FMemory::Memzero(&Blocks.AddUninitialized_GetRef(), sizeof(FBlock));
+	}
+
+	auto& Block = Blocks.Last();
+	const auto& Location = Frame.PlaneLocation;
+
+	Block.ForwardX[Lane] = Frame.Forward.X;
+	Block.ForwardY[Lane] = Frame.Forward.Y;
+	Block.ForwardZ[Lane] = Frame.Forward.Z;
+	Block.ForwardW[Lane] = Location.Dot(Frame.Forward);
+	Block.RightX[Lane] = Frame.Right.X;
+	Block.RightY[Lane] = Frame.Right.Y;
+	Block.RightZ[Lane] = Frame.Right.Z;
+	Block.RightW[Lane] = Location.Dot(Frame.Right);
+	Block.UpX[Lane] = Frame.Up.X;
+	Block.UpY[Lane] = Frame.Up.Y;
+	Block.UpZ[Lane] = Frame.Up.Z;
+	Block.UpW[Lane] = Location.Dot(Frame.Up);
+
+	return NumQuads++;
+}
+
+int32 FPortalQuads::Num() const
+{
+	return NumQuads;
+}
+
+std::optional<FPortalRayHit> FPortalQuads::Raycast(
+	const FVector& Start,
+	const FVector& End,
+	TConstArrayView<int32> IgnoredIndices) const
+{
+	const auto Delta = End - Start;
+
+	const auto StartX = MakeVectorRegisterDouble(Start.X, Start.X, Start.X, Start.X);
+	const auto StartY = MakeVectorRegisterDouble(Start.Y, Start.Y, Start.Y, Start.Y);
+	const auto StartZ = MakeVectorRegisterDouble(Start.Z, Start.Z, Start.Z, Start.Z);
+	const auto DeltaX = MakeVectorRegisterDouble(Delta.X, Delta.X, Delta.X, Delta.X);
+	const auto DeltaY = MakeVectorRegisterDouble(Delta.Y, Delta.Y, Delta.Y, Delta.Y);
+	const auto DeltaZ = MakeVectorRegisterDouble(Delta.Z, Delta.Z, Delta.Z, Delta.Z);
+
+	const auto Zero = MakeVectorRegisterDouble(0.0, 0.0, 0.0, 0.0);
+	const auto RightHalf = MakeVectorRegisterDouble(
+		PORTAL_RIGHT_SIZE_HALF, PORTAL_RIGHT_SIZE_HALF, PORTAL_RIGHT_SIZE_HALF, PORTAL_RIGHT_SIZE_HALF);
+	const auto UpHalf = MakeVectorRegisterDouble(
+		PORTAL_UP_SIZE_HALF, PORTAL_UP_SIZE_HALF, PORTAL_UP_SIZE_HALF, PORTAL_UP_SIZE_HALF);
+
+	std::optional<FPortalRayHit> Nearest;
+
+	for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); ++BlockIndex)
+	{
+		const auto& Block = Blocks[BlockIndex];
+
+		const auto StartDistance = VectorSubtract(
+			Dot(StartX, StartY, StartZ, Block.ForwardX, Block.ForwardY, Block.ForwardZ),
+			VectorLoad(Block.ForwardW));
+		const auto EndDistance = VectorAdd(
+			StartDistance,
+			Dot(DeltaX, DeltaY, DeltaZ, Block.ForwardX, Block.ForwardY, Block.ForwardZ));
+
+		// Should move from the front side to the back side.
+		const auto Crosses = VectorBitwiseAnd(
+			VectorCompareGT(StartDistance, Zero),
+			VectorCompareLE(EndDistance, Zero));
+
+		if (VectorMaskBits(Crosses) == 0)
+			continue;
+
+		// Lanes which do not cross may divide by zero, but are masked out.
+		const auto Time = VectorDivide(
+			StartDistance,
+			VectorSubtract(StartDistance, EndDistance));
+
+		const auto CrossingRight = VectorMultiplyAdd(
+			Time,
+			Dot(DeltaX, DeltaY, DeltaZ, Block.RightX, Block.RightY, Block.RightZ),
+			VectorSubtract(
+				Dot(StartX, StartY, StartZ, Block.RightX, Block.RightY, Block.RightZ),
+				VectorLoad(Block.RightW)));
+		const auto CrossingUp = VectorMultiplyAdd(
+			Time,
+			Dot(DeltaX, DeltaY, DeltaZ, Block.UpX, Block.UpY, Block.UpZ),
+			VectorSubtract(
+				Dot(StartX, StartY, StartZ, Block.UpX, Block.UpY, Block.UpZ),
+				VectorLoad(Block.UpW)));
+
+		const auto Inside = VectorBitwiseAnd(
+			VectorCompareLE(VectorAbs(CrossingRight), RightHalf),
+			VectorCompareLE(VectorAbs(CrossingUp), UpHalf));
+
+		const auto HitMask = VectorMaskBits(VectorBitwiseAnd(Crosses, Inside));
+		if (HitMask == 0)
+			continue;
+
+		double Times[LANES];
+		VectorStore(Time, Times);
+
+		for (int32 Lane = 0; Lane < LANES; ++Lane)
+		{
+			if (!(HitMask & (1 << Lane)))
+				continue;
+
+			if (Nearest && Nearest->Time <= Times[Lane])
+				continue;
+
+			const auto Index = BlockIndex * LANES + Lane;
+			if (IgnoredIndices.Contains(Index))
+				continue;
+
+			Nearest = FPortalRayHit{
+				Index,
+				Times[Lane],
+				Start + Delta * Times[Lane] };
+		}
+	}
+
+	return Nearest;
+}
+
+VectorRegister4Double FPortalQuads::Dot(
+	const VectorRegister4Double& X,
+	const VectorRegister4Double& Y,
+	const VectorRegister4Double& Z,
+	const double* LaneX,
+	const double* LaneY,
+	const double* LaneZ)
+{
+	return VectorMultiplyAdd(
+		X,
+		VectorLoad(LaneX),
+		VectorMultiplyAdd(
+			Y,
+			VectorLoad(LaneY),
+			VectorMultiply(Z, VectorLoad(LaneZ))));
+}
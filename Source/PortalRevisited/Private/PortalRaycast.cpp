@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalRaycast.h"
+
+#include "PortalRevisited/Portal.h"
+
+// Traces stop short of the portal plane,
+// not to hit the wall the portal is placed on.
+constexpr double PORTAL_RAYCAST_OCCLUDER_MARGIN = 1.0;
+// The ray leaves a portal a little in front of it,
+// not to hit the wall the portal is placed on.
+constexpr double PORTAL_RAYCAST_HOP_OFFSET = 10.0;
+
+bool FPortalRaycastQuery::operator==(const FPortalRaycastQuery& Other) const
+{
+	return
+		Start == Other.Start &&
+		Direction == Other.Direction &&
+		Range == Other.Range &&
+		Channel == Other.Channel &&
+		MaxHops == Other.MaxHops &&
+		bReturnPhysicalMaterial == Other.bReturnPhysicalMaterial &&
+		IgnoredActors == Other.IgnoredActors;
+}
+
+bool FPortalRaycast::IsStale() const
+{
+	return !Frame || *Frame != GFrameCounter;
+}
+
+void FPortalRaycast::Reset()
+{
+	Quads.Reset();
+	QuadPortals.Reset();
+	QuadFrames.Reset();
+	QuadLinks.Reset();
+	UnlinkedQuads.Reset();
+	AllPortals.Reset();
+
+	Queries.Reset();
+	Results.Reset();
+
+	Frame = GFrameCounter;
+}
+
+void FPortalRaycast::Invalidate()
+{
+	Frame.reset();
+}
+
+void FPortalRaycast::AddPair(TObjectPtr<APortal> First, TObjectPtr<APortal> Second)
+{
+	AllPortals.Add(First);
+	AllPortals.Add(Second);
+
+	// The ray can pass only if the portal leads somewhere,
+	// but a placed portal still stops it.
+	if (!First->IsActivated() || !Second->IsActivated())
+	{
+		for (const auto& Portal : { First, Second })
+		{
+			if (!Portal->IsActivated())
+				continue;
+
+			const auto Frame = FPortalFrame::Make(*Portal);
+			UnlinkedQuads.Add(Quads.Add(Frame));
+			QuadPortals.Add(Portal);
+			QuadFrames.Add(Frame);
+			QuadLinks.Add(INDEX_NONE);
+		}
+		return;
+	}
+
+	const auto FirstFrame = FPortalFrame::Make(*First);
+	const auto SecondFrame = FPortalFrame::Make(*Second);
+
+	const auto FirstIndex = Quads.Add(FirstFrame);
+	const auto SecondIndex = Quads.Add(SecondFrame);
+
+	QuadPortals.Add(First);
+	QuadPortals.Add(Second);
+	QuadFrames.Add(FirstFrame);
+	QuadFrames.Add(SecondFrame);
+	QuadLinks.Add(SecondIndex);
+	QuadLinks.Add(FirstIndex);
+}
+
+FPortalRaycastResult FPortalRaycast::Raycast(
+	const UWorld& World,
+	const FPortalRaycastQuery& Query)
+{
+	const auto Index = Queries.IndexOfByKey(Query);
+	if (Index != INDEX_NONE)
+	{
+		return Results[Index];
+	}
+
+	Queries.Add(Query);
+	return Results.Add_GetRef(Trace(World, Query));
+}
+
+std::optional<FPortalCrossing> FPortalRaycast::FindCrossing(
+	const FVector& Start,
+	const FVector& End) const
+{
+	const auto PortalHit = Quads.Raycast(Start, End, UnlinkedQuads);
+	if (!PortalHit)
+	{
+		return std::nullopt;
+	}
+
+	const auto DestIndex = QuadLinks[PortalHit->Index];
+
+	return FPortalCrossing{
+		QuadPortals[PortalHit->Index],
+		PortalHit->Time,
+		PortalHit->Location,
+		QuadFrames[PortalHit->Index],
+		QuadFrames[DestIndex],
+		QuadPortals[DestIndex] };
+}
+
+FPortalRaycastTrace FPortalRaycast::MakeTrace(const FPortalRaycastQuery& Query) const
+{
+	check(Query.MaxHops == 0);
+
+	const auto End = Query.Start + Query.Direction * Query.Range;
+	const auto PortalHit = Quads.Raycast(Query.Start, End, GetIgnoredQuads(Query));
+
+	FPortalRaycastTrace Trace;
+	Trace.Start = Query.Start;
+	Trace.End = PortalHit ?
+		PortalHit->Location - Query.Direction * PORTAL_RAYCAST_OCCLUDER_MARGIN :
+		End;
+	Trace.Channel = Query.Channel;
+	Trace.CollisionParams = MakeCollisionParams(Query);
+
+	return Trace;
+}
+
+FCollisionQueryParams FPortalRaycast::MakeCollisionParams(const FPortalRaycastQuery& Query) const
+{
+	FCollisionQueryParams CollisionParams;
+	CollisionParams.bReturnPhysicalMaterial = Query.bReturnPhysicalMaterial;
+	for (const auto& Actor : Query.IgnoredActors)
+	{
+		CollisionParams.AddIgnoredActor(Actor);
+	}
+
+	// Portals are found by their quads.
+	for (const auto& Portal : AllPortals)
+	{
+		CollisionParams.AddIgnoredActor(Portal);
+	}
+
+	return CollisionParams;
+}
+
+TArray<int32, TInlineAllocator<2>> FPortalRaycast::GetIgnoredQuads(const FPortalRaycastQuery& Query) const
+{
+	TArray<int32, TInlineAllocator<2>> IgnoredQuads;
+	for (int32 i = 0; i < QuadPortals.Num(); ++i)
+	{
+		if (Query.IgnoredActors.Contains(QuadPortals[i].Get()))
+		{
+			IgnoredQuads.Add(i);
+		}
+	}
+
+	return IgnoredQuads;
+}
+
+FPortalRaycastResult FPortalRaycast::Trace(
+	const UWorld& World,
+	const FPortalRaycastQuery& Query) const
+{
+	FPortalRaycastResult Result;
+	Result.PortalTransform = FTransform::Identity;
+
+	const auto CollisionParams = MakeCollisionParams(Query);
+	const auto IgnoredQuads = GetIgnoredQuads(Query);
+
+	auto Start = Query.Start;
+	auto Direction = Query.Direction;
+	auto RemainRange = Query.Range;
+
+	TArray<FHitResult> HitResults;
+
+	for (int32 Hop = 0; ; ++Hop)
+	{
+		const auto End = Start + Direction * RemainRange;
+		const auto PortalHit = Quads.Raycast(Start, End, IgnoredQuads);
+
+		const auto TraceEnd = PortalHit ?
+			PortalHit->Location - Direction * PORTAL_RAYCAST_OCCLUDER_MARGIN :
+			End;
+
+		World.LineTraceMultiByChannel(
+			HitResults,
+			Start,
+			TraceEnd,
+			Query.Channel,
+			CollisionParams);
+
+		if (!HitResults.IsEmpty())
+		{
+			Result.Hit = HitResults[0];
+			return Result;
+		}
+
+		if (!PortalHit)
+		{
+			return Result;
+		}
+
+		const auto& SrcPortal = QuadPortals[PortalHit->Index];
+		if (Hop == Query.MaxHops || QuadLinks[PortalHit->Index] == INDEX_NONE)
+		{
+			Result.StoppedPortal = SrcPortal;
+			Result.StoppedLocation = PortalHit->Location;
+			return Result;
+		}
+
+		const auto& Src = QuadFrames[PortalHit->Index];
+		const auto& Dest = QuadFrames[QuadLinks[PortalHit->Index]];
+
+		RemainRange -= (PortalHit->Location - Start).Length();
+		Direction = Src.TransformVectorTo(Dest, Direction);
+
+		const auto StartOffset =
+			PORTAL_RAYCAST_HOP_OFFSET / Direction.Dot(Dest.Forward);
+		Start =
+			Src.TransformPointTo(Dest, PortalHit->Location) +
+			Direction * StartOffset;
+
+		Result.PassedPortals.Add(SrcPortal);
+		Result.PortalTransform = Result.PortalTransform * Src.GetTransformTo(Dest);
+	}
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalSnapshot.h"
+
+#include "PortalClipLocation.h"
+#include "PortalRevisited/Portal.h"
+
+FPortalFrame FPortalFrame::Make(const APortal& Portal)
+{
+	FPortalFrame Frame;
+	Frame.PlaneLocation = Portal.GetPortalPlaneLocation();
+	Frame.Quat = Portal.GetActorQuat();
+	Frame.Forward = Portal.GetPortalForwardVector();
+	Frame.Right = Portal.GetPortalRightVector();
+	Frame.Up = Portal.GetPortalUpVector();
+
+	return Frame;
+}
+
+FVector FPortalFrame::TransformPointTo(const FPortalFrame& Dest, const FVector& Target) const
+{
+	return APortal::TransformPointToDestSpace(
+		Target,
+		PlaneLocation,
+		Forward,
+		Right,
+		Up,
+		Dest.PlaneLocation,
+		-Dest.Forward,
+		-Dest.Right,
+		Dest.Up);
+}
+
+FVector FPortalFrame::TransformVectorTo(const FPortalFrame& Dest, const FVector& Target) const
+{
+	return APortal::TransformVectorToDestSpace(
+		Target,
+		Forward,
+		Right,
+		Up,
+		-Dest.Forward,
+		-Dest.Right,
+		Dest.Up);
+}
+
+FQuat FPortalFrame::TransformQuatTo(const FPortalFrame& Dest, const FQuat& Target) const
+{
+	return APortal::TransformQuatToDestSpace(
+		Target,
+		Quat,
+		Dest.Quat,
+		Dest.Up);
+}
+
+FTransform FPortalFrame::GetTransformTo(const FPortalFrame& Dest) const
+{
+	// Passing a portal turns around the up vector.
+	const FTransform SrcTransform(Forward, Right, Up, PlaneLocation);
+	const FTransform DestTransform(-Dest.Forward, -Dest.Right, Dest.Up, Dest.PlaneLocation);
+
+	return SrcTransform.Inverse() * DestTransform;
+}
+
+void FPortalResult::Reset()
+{
+	CloneLocations.Reset();
+	CloneQuats.Reset();
+	CrossedIndex = INDEX_NONE;
+	bVisible = false;
+}
+
+void FPortalSnapshot::Reset()
+{
+	bActivated = false;
+	bCheckTraversal = false;
+
+	Originals.Reset();
+	OriginalLocations.Reset();
+	OriginalQuats.Reset();
+	TrackedLocations.Reset();
+	LastLocations.Reset();
+	LastLocationFrames.Reset();
+	Flags.Reset();
+}
+
+void FPortalSnapshot::Compute(const FPortalFrame& DestFrame, FPortalResult& Result) const
+{
+	Result.Reset();
+
+	const auto Num = Originals.Num();
+	Result.CloneLocations.SetNumUninitialized(Num);
+	Result.CloneQuats.SetNumUninitialized(Num);
+
+	for (int32 i = 0; i < Num; ++i)
+	{
+		Result.CloneLocations[i] =
+			Frame.TransformPointTo(DestFrame, OriginalLocations[i]);
+		Result.CloneQuats[i] =
+			Frame.TransformQuatTo(DestFrame, OriginalQuats[i]);
+	}
+
+	if (bCheckTraversal)
+	{
+		for (int32 i = 0; i < Num; ++i)
+		{
+			if (EnumHasAnyFlags(Flags[i], EPortalTrackedFlags::HandlesTraversal))
+				continue;
+
+			const auto bAcrossedPortal =
+				APortal::DoesSegmentCrossPortal(
+					LastLocations[i],
+					TrackedLocations[i],
+					Frame.PlaneLocation,
+					Frame.Forward,
+					Frame.Right,
+					Frame.Up);
+
+			// Teleport only single actor in a frame, as the
+			// serial check did.
+			if (bAcrossedPortal)
+			{
+				Result.CrossedIndex = i;
+				break;
+			}
+		}
+	}
+}
+
+bool FPortalSnapshot::IsVisibleFrom(const FMatrix& ViewProjectionMatrix) const
+{
+	return bActivated && !UPortalClipLocation::CannotSeePortal(
+		ViewProjectionMatrix,
+		Frame.PlaneLocation,
+		Frame.Right,
+		Frame.Up);
+}
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalStats.h"
+
+DEFINE_STAT(STAT_PortalComputeSnapshots);
+DEFINE_STAT(STAT_PortalUpdateClones);
+DEFINE_STAT(STAT_PortalTraversal);
+DEFINE_STAT(STAT_PortalRegisterOverlappingActor);
+DEFINE_STAT(STAT_PortalUpdateClipLocation);
+DEFINE_STAT(STAT_PortalUpdateCapture);
+DEFINE_STAT(STAT_PortalCaptureScene0);
+DEFINE_STAT(STAT_PortalCaptureScene1);
+DEFINE_STAT(STAT_PortalSolvePlacement);
+
+DEFINE_STAT(STAT_PortalCaptures);
+DEFINE_STAT(STAT_PortalSkippedCaptures);
+DEFINE_STAT(STAT_PortalClones);
+DEFINE_STAT(STAT_PortalTeleports);
+
+CSV_DEFINE_CATEGORY_MODULE(PORTALREVISITED_API, Portal, true);
@@ -0,0 +1,450 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalSubsystem.h"
+
+#include "PortalPhysicsTeleport.h"
+#include "PortalStats.h"
+#include "PortalTrace.h"
+#include "PortalRevisited/Portal.h"
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "PBDRigidsSolver.h"
+
+TRACE_DECLARE_INT_COUNTER(PortalTrackedActors, TEXT("Portal/TrackedActors"));
+TRACE_DECLARE_MEMORY_COUNTER(PortalRenderTargetMemory, TEXT("Portal/RenderTargetMemory"));
+
+void UPortalSubsystem::RegisterPair(
+	TObjectPtr<APortal> First,
+	TObjectPtr<APortal> Second,
+	bool bPhysicsThreadTeleport)
+{
+	UnregisterPair(First);
+	UnregisterPair(Second);
+
+	auto& Pair = Pairs.Emplace_GetRef();
+	Pair.First = First;
+	Pair.Second = Second;
+
+	if (bPhysicsThreadTeleport)
+	{
+		RegisterPhysicsTeleport(Pair);
+	}
+
+	First->SetPhysicsThreadTeleport(Pair.PhysicsTeleport != nullptr);
+	Second->SetPhysicsThreadTeleport(Pair.PhysicsTeleport != nullptr);
+
+	InvalidateRaycasts();
+}
+
+void UPortalSubsystem::UnregisterPair(TObjectPtr<APortal> Portal)
+{
+	for (int32 i = Pairs.Num() - 1; i >= 0; --i)
+	{
+		auto& Pair = Pairs[i];
+		if (Pair.First != Portal && Pair.Second != Portal)
+			continue;
+
+		UnregisterPhysicsTeleport(Pair);
+		Pairs.RemoveAtSwap(i);
+		InvalidateRaycasts();
+	}
+}
+
+FPortalRaycastResult UPortalSubsystem::Raycast(const FPortalRaycastQuery& Query)
+{
+	UpdateRaycaster();
+
+	return Raycaster.Raycast(*GetWorld(), Query);
+}
+
+FPortalRaycastTrace UPortalSubsystem::MakeRaycastTrace(const FPortalRaycastQuery& Query)
+{
+	UpdateRaycaster();
+
+	return Raycaster.MakeTrace(Query);
+}
+
+std::optional<FPortalCrossing> UPortalSubsystem::FindPortalCrossing(
+	const FVector& Start,
+	const FVector& End)
+{
+	UpdateRaycaster();
+
+	return Raycaster.FindCrossing(Start, End);
+}
+
+void UPortalSubsystem::UpdateRaycaster()
+{
+	if (!Raycaster.IsStale())
+		return;
+
+	Raycaster.Reset();
+
+	for (const auto& Pair : Pairs)
+	{
+		if (!Pair.First || !Pair.Second)
+			continue;
+
+		Raycaster.AddPair(Pair.First, Pair.Second);
+	}
+}
+
+void UPortalSubsystem::InvalidateRaycasts()
+{
+	Raycaster.Invalidate();
+}
+
+const FPortalSurfaceIndex& UPortalSubsystem::GetSurfaceIndex() const
+{
+	return SurfaceIndex;
+}
+
+void UPortalSubsystem::RegisterPhysicsTeleport(FPortalPair& Pair)
+{
+	const auto PhysicsScene = GetWorld()->GetPhysicsScene();
+	if (!PhysicsScene)
+	{
+		UE_LOG(Portal, Warning, TEXT("Cannot find the physics scene. Bodies are teleported on the game thread."));
+		return;
+	}
+
+	Pair.PhysicsTeleport =
+		PhysicsScene->GetSolver()->
+			CreateAndRegisterSimCallbackObject_External<FPortalPhysicsTeleport>();
+}
+
+void UPortalSubsystem::UnregisterPhysicsTeleport(FPortalPair& Pair)
+{
+	if (!Pair.PhysicsTeleport)
+		return;
+
+	if (const auto PhysicsScene = GetWorld()->GetPhysicsScene())
+	{
+		PhysicsScene->GetSolver()->
+			UnregisterAndFreeSimCallbackObject_External(Pair.PhysicsTeleport);
+	}
+
+	Pair.PhysicsTeleport = nullptr;
+}
+
+void UPortalSubsystem::UpdatePhysicsTeleport(const FPortalPair& Pair)
+{
+	const auto PhysicsTeleport = Pair.PhysicsTeleport;
+
+	// The bodies are already on the other side. Let the portals
+	// do the rest of passing them on the game thread.
+	while (const auto Output = PhysicsTeleport->PopOutputData_External())
+	{
+		for (const auto& Body : Output->TeleportedBodies)
+		{
+			const auto& SrcPortal = Body.bAtFirst ? Pair.First : Pair.Second;
+			SrcPortal->HandleBodyPassed(Body.Proxy);
+		}
+	}
+
+	auto Input = PhysicsTeleport->GetProducerInputData_External();
+	Input->Reset();
+
+	// The bodies can pass only if the portal leads somewhere.
+	if (!Pair.First->IsActivated() || !Pair.Second->IsActivated())
+		return;
+
+	Input->First = FPortalFrame::Make(*Pair.First);
+	Input->Second = FPortalFrame::Make(*Pair.Second);
+	Pair.First->CollectPhysicsTeleportBodies(true, Input->Bodies);
+	Pair.Second->CollectPhysicsTeleportBodies(false, Input->Bodies);
+}
+
+void FPortalPrePhysicsTickFunction::ExecuteTick(
+	float DeltaTime,
+	ELevelTick TickType,
+	ENamedThreads::Type CurrentThread,
+	const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Target->TickPrePhysics(DeltaTime);
+	}
+}
+
+FString FPortalPrePhysicsTickFunction::DiagnosticMessage()
+{
+	return TEXT("FPortalPrePhysicsTickFunction");
+}
+
+void FPortalPostUpdateTickFunction::ExecuteTick(
+	float DeltaTime,
+	ELevelTick TickType,
+	ENamedThreads::Type CurrentThread,
+	const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Target->TickPostUpdate(DeltaTime);
+	}
+}
+
+FString FPortalPostUpdateTickFunction::DiagnosticMessage()
+{
+	return TEXT("FPortalPostUpdateTickFunction");
+}
+
+void UPortalSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	PrePhysicsTickFunction.Target = this;
+	PrePhysicsTickFunction.TickGroup = TG_PrePhysics;
+	PrePhysicsTickFunction.bCanEverTick = true;
+	PrePhysicsTickFunction.bStartWithTickEnabled = true;
+	PrePhysicsTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+
+	PostUpdateTickFunction.Target = this;
+	PostUpdateTickFunction.TickGroup = TG_PostUpdateWork;
+	PostUpdateTickFunction.bCanEverTick = true;
+	PostUpdateTickFunction.bStartWithTickEnabled = true;
+	PostUpdateTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+
+	const auto MapName = UWorld::RemovePIEPrefix(InWorld.GetMapName());
+	if (!SurfaceIndex.Load(FPortalSurfaceIndex::GetIndexPath(MapName)))
+	{
+		UE_LOG(Portal, Log, TEXT("No portal surface index for %s. Portals are placed within actor bounds."), *MapName);
+	}
+}
+
+void UPortalSubsystem::Deinitialize()
+{
+	for (auto& Pair : Pairs)
+	{
+		UnregisterPhysicsTeleport(Pair);
+	}
+
+	if (PrePhysicsTickFunction.IsTickFunctionRegistered())
+	{
+		PrePhysicsTickFunction.UnRegisterTickFunction();
+	}
+	PrePhysicsTickFunction.Target = nullptr;
+
+	if (PostUpdateTickFunction.IsTickFunctionRegistered())
+	{
+		PostUpdateTickFunction.UnRegisterTickFunction();
+	}
+	PostUpdateTickFunction.Target = nullptr;
+	NumPendingWorks = 0;
+
+	SurfaceIndex.Unload();
+
+	Super::Deinitialize();
+}
+
+bool UPortalSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UPortalSubsystem::TickPrePhysics(float DeltaTime)
+{
+	PORTAL_TRACE_SCOPE(Portal_TickPrePhysics);
+
+	for (const auto& Pair : Pairs)
+	{
+		if (!Pair.First || !Pair.Second)
+			continue;
+
+		if (Pair.PhysicsTeleport)
+		{
+			UpdatePhysicsTeleport(Pair);
+		}
+
+		// A teleport moves an actor to the other side, so the other
+		// side is left to the correction after the update.
+		if (!Pair.First->PredictTraversal(DeltaTime))
+		{
+			Pair.Second->PredictTraversal(DeltaTime);
+		}
+	}
+}
+
+void UPortalSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	PORTAL_TRACE_SCOPE(Portal_Tick);
+	TraceCounters();
+
+	// Copy the awake pairs on the game thread.
+	NumPendingWorks = 0;
+	int32 NumWorks = 0;
+	for (const auto& Pair : Pairs)
+	{
+		if (!Pair.First || !Pair.Second)
+			continue;
+
+		// Sleep while neither side is seen nor holds any actor.
+		if (!Pair.First->HasWork() && !Pair.Second->HasWork())
+			continue;
+
+		if (Works.Num() <= NumWorks)
+		{
+			Works.AddDefaulted();
+		}
+
+		auto& Work = Works[NumWorks++];
+		Work.First = Pair.First;
+		Work.Second = Pair.Second;
+		Pair.First->MakeSnapshot(DeltaTime, Work.FirstSnapshot);
+		Pair.Second->MakeSnapshot(DeltaTime, Work.SecondSnapshot);
+	}
+
+	// Every pair sleeps, so nothing else runs this frame.
+	if (NumWorks == 0)
+		return;
+
+	// Snapshots are only read here, so pairs run on any thread.
+	ParallelFor(NumWorks, [this](int32 Index)
+	{
+		PORTAL_SCOPE_CYCLE_COUNTER(ComputeSnapshots);
+
+		auto& Work = Works[Index];
+		Work.FirstSnapshot.Compute(Work.SecondSnapshot.Frame, Work.FirstResult);
+		Work.SecondSnapshot.Compute(Work.FirstSnapshot.Frame, Work.SecondResult);
+	});
+
+	for (int32 i = 0; i < NumWorks; ++i)
+	{
+		CommitPair(Works[i], DeltaTime);
+	}
+
+	NumPendingWorks = NumWorks;
+}
+
+void UPortalSubsystem::TickPostUpdate(float DeltaTime)
+{
+	PORTAL_TRACE_SCOPE(Portal_TickPostUpdate);
+
+	// The camera manager has updated by now, so the captures
+	// follow the view of this frame.
+	const auto View = GetPlayerView();
+	if (View)
+	{
+		for (int32 i = 0; i < NumPendingWorks; ++i)
+		{
+			CommitCaptures(Works[i], DeltaTime, *View);
+		}
+	}
+
+	NumPendingWorks = 0;
+}
+
+void UPortalSubsystem::CommitPair(const FPortalPairWork& Work, float DeltaTime)
+{
+	const auto& First = Work.First;
+	const auto& Second = Work.Second;
+
+	First->CommitClones(Work.FirstSnapshot, Work.FirstResult);
+	Second->CommitClones(Work.SecondSnapshot, Work.SecondResult);
+
+	// A teleport moves an actor to the other side, so the result of the
+	// other side is stale then. It is swept again in the next frame.
+	if (!First->CommitTraversal(Work.FirstSnapshot, Work.FirstResult))
+	{
+		Second->CommitTraversal(Work.SecondSnapshot, Work.SecondResult);
+	}
+
+	First->UpdateLeavingActors(DeltaTime);
+	Second->UpdateLeavingActors(DeltaTime);
+}
+
+void UPortalSubsystem::CommitCaptures(
+	FPortalPairWork& Work,
+	float DeltaTime,
+	const FPortalView& View)
+{
+	const auto& First = Work.First;
+	const auto& Second = Work.Second;
+
+	// The pair may have been removed since the tick.
+	if (!IsValid(First) || !IsValid(Second))
+		return;
+
+	Work.FirstResult.bVisible =
+		Work.FirstSnapshot.IsVisibleFrom(View.ViewProjectionMatrix);
+	Work.SecondResult.bVisible =
+		Work.SecondSnapshot.IsVisibleFrom(View.ViewProjectionMatrix);
+
+	const auto bFirstVisible =
+		First->CommitClipParameters(View, Work.FirstResult);
+	const auto bSecondVisible =
+		Second->CommitClipParameters(View, Work.SecondResult);
+
+	if (bFirstVisible)
+	{
+		First->UpdateCapture(DeltaTime, View);
+	}
+
+	if (bSecondVisible)
+	{
+		Second->UpdateCapture(DeltaTime, View);
+	}
+
+	PORTAL_INC_COUNTER(SkippedCaptures, !bFirstVisible + !bSecondVisible);
+}
+
+void UPortalSubsystem::TraceCounters() const
+{
+	if (!UE_TRACE_CHANNELEXPR_IS_ENABLED(PortalChannel))
+		return;
+
+	int64 NumTracked = 0;
+	int64 RenderTargetBytes = 0;
+
+	for (const auto& Pair : Pairs)
+	{
+		for (const auto& Portal : { Pair.First, Pair.Second })
+		{
+			if (!Portal)
+				continue;
+
+			NumTracked += Portal->GetNumTracked();
+			RenderTargetBytes += Portal->GetRenderTargetBytes();
+		}
+	}
+
+	TRACE_COUNTER_SET(PortalTrackedActors, NumTracked);
+	TRACE_COUNTER_SET(PortalRenderTargetMemory, RenderTargetBytes);
+}
+
+std::optional<FPortalView> UPortalSubsystem::GetPlayerView() const
+{
+	const auto PlayerController = GetWorld()->GetFirstPlayerController();
+	if (!PlayerController || !PlayerController->PlayerCameraManager)
+		return std::nullopt;
+
+	const auto PlayerCameraManager = PlayerController->PlayerCameraManager;
+
+	FPortalView View;
+	View.Location = PlayerCameraManager->GetCameraLocation();
+	View.Rotation = PlayerCameraManager->GetCameraRotation().Quaternion();
+
+	FMatrix UnusedViewMatrix;
+	UGameplayStatics::GetViewProjectionMatrix(
+		PlayerCameraManager->GetCameraCacheView(),
+		UnusedViewMatrix,
+		View.ProjectionMatrix,
+		View.ViewProjectionMatrix);
+
+	return View;
+}
+
+bool UPortalSubsystem::IsTickable() const
+{
+	return !Pairs.IsEmpty();
+}
+
+TStatId UPortalSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPortalSubsystem, STATGROUP_Tickables);
+}
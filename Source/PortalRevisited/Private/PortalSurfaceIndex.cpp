@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalSurfaceIndex.h"
+
+#include "PortalRevisited/Portal.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// How far the point can be off the surface.
+constexpr float PORTAL_SURFACE_DISTANCE_TOLERANCE = 2.f;
+// Cosine of the angle the normal can be off the surface normal.
+constexpr float PORTAL_SURFACE_NORMAL_TOLERANCE = 0.99f;
+
+FPortalSurfaceIndex::FPortalSurfaceIndex() = default;
+
+// Defined here, where the mapped file types are complete.
+FPortalSurfaceIndex::~FPortalSurfaceIndex()
+{
+	Unload();
+}
+
+FString FPortalSurfaceIndex::GetIndexPath(const FString& MapName)
+{
+	return FPaths::ProjectContentDir() / TEXT("PortalSurfaces") / MapName + TEXT(".psi");
+}
+
+bool FPortalSurfaceIndex::Save(const FString& Path, TConstArrayView<FPortalSurfaceRect> Rects)
+{
+	FHeader Header;
+	Header.Magic = MAGIC;
+	Header.Version = VERSION;
+	Header.NumRects = Rects.Num();
+	Header.Padding = 0;
+
+	TArray<uint8> Data;
+	Data.Append(reinterpret_cast<const uint8*>(&Header), sizeof(FHeader));
+	Data.Append(reinterpret_cast<const uint8*>(Rects.GetData()), Rects.Num() * sizeof(FPortalSurfaceRect));
+
+	return FFileHelper::SaveArrayToFile(Data, *Path);
+}
+
+bool FPortalSurfaceIndex::Load(const FString& Path)
+{
+	Unload();
+
+	auto& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!PlatformFile.FileExists(*Path))
+	{
+		return false;
+	}
+
+	MappedFile.Reset(PlatformFile.OpenMapped(*Path));
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+
+	if (MappedRegion)
+	{
+		if (SetRects(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize()))
+		{
+			return true;
+		}
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedData, *Path))
+	{
+		if (SetRects(LoadedData.GetData(), LoadedData.Num()))
+		{
+			return true;
+		}
+	}
+
+	UE_LOG(Portal, Warning, TEXT("Cannot load the portal surface index: %s"), *Path);
+	Unload();
+	return false;
+}
+
+void FPortalSurfaceIndex::Unload()
+{
+	Rects = {};
+
+	// The region should be unmapped before the file is closed.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedData.Empty();
+}
+
+bool FPortalSurfaceIndex::IsLoaded() const
+{
+	return MappedRegion || !LoadedData.IsEmpty();
+}
+
+const FPortalSurfaceRect* FPortalSurfaceIndex::FindSurface(
+	const FVector& Point,
+	const FVector& Normal) const
+{
+	const auto Point3f = FVector3f(Point);
+	const auto Normal3f = FVector3f(Normal);
+
+	for (const auto& Rect : Rects)
+	{
+		if (Rect.Normal.Dot(Normal3f) < PORTAL_SURFACE_NORMAL_TOLERANCE)
+			continue;
+
+		const auto CenterToPoint = Point3f - Rect.Center;
+
+		if (FMath::Abs(CenterToPoint.Dot(Rect.Normal)) > PORTAL_SURFACE_DISTANCE_TOLERANCE ||
+			FMath::Abs(CenterToPoint.Dot(Rect.Right)) > Rect.HalfRight ||
+			FMath::Abs(CenterToPoint.Dot(Rect.Up)) > Rect.HalfUp)
+		{
+			continue;
+		}
+
+		return &Rect;
+	}
+
+	return nullptr;
+}
+
+bool FPortalSurfaceIndex::SetRects(const uint8* Data, int64 Size)
+{
+	if (Size < static_cast<int64>(sizeof(FHeader)))
+	{
+		return false;
+	}
+
+	const auto Header = reinterpret_cast<const FHeader*>(Data);
+	if (Header->Magic != MAGIC || Header->Version != VERSION)
+	{
+		return false;
+	}
+
+	const auto RectsSize =
+		static_cast<int64>(Header->NumRects) * sizeof(FPortalSurfaceRect);
+	if (Size < static_cast<int64>(sizeof(FHeader)) + RectsSize)
+	{
+		return false;
+	}
+
+	Rects = MakeArrayView(
+		reinterpret_cast<const FPortalSurfaceRect*>(Data + sizeof(FHeader)),
+		Header->NumRects);
+
+	return true;
+}
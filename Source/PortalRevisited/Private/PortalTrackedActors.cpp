@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalTrackedActors.h"
+
+#include "CoreGlobals.h"
+#include "UObject/UObjectGlobals.h"
+
+int32 FPortalTrackedActors::Add(
+	TObjectPtr<AActor> Original,
+	TObjectPtr<UPrimitiveComponent> Primitive,
+	TObjectPtr<USceneComponent> TrackedComponent,
+	EPortalTrackedKind Kind,
+	EPortalTrackedFlags NewFlags)
+{
+	const auto Index = Originals.Add(Original);
+	Clones.Add(nullptr);
+	Primitives.Add(Primitive);
+	TrackedComponents.Add(TrackedComponent);
+	Kinds.Add(Kind);
+	LastLocations.Add(TrackedComponent->GetComponentLocation());
+	LastLocationFrames.Add(GFrameCounter);
+	Flags.Add(NewFlags);
+	TimesOutside.Add(0.f);
+
+	OriginalIndices.Add(Original, Index);
+
+	return Index;
+}
+
+void FPortalTrackedActors::SetClone(int32 Index, TObjectPtr<AActor> Clone)
+{
+	ClearClone(Index);
+
+	Clones[Index] = Clone;
+	CloneIndices.Add(Clone, Index);
+}
+
+void FPortalTrackedActors::ClearClone(int32 Index)
+{
+	RemoveIndex(CloneIndices, Clones[Index], Index);
+	Clones[Index] = nullptr;
+}
+
+void FPortalTrackedActors::RemoveAtSwap(int32 Index)
+{
+	ClearClone(Index);
+	RemoveIndex(OriginalIndices, Originals[Index], Index);
+
+	const auto LastIndex = Num() - 1;
+	if (Index != LastIndex)
+	{
+		MoveIndex(OriginalIndices, Originals[LastIndex], LastIndex, Index);
+		MoveIndex(CloneIndices, Clones[LastIndex], LastIndex, Index);
+	}
+
+	Originals.RemoveAtSwap(Index, 1, false);
+	Clones.RemoveAtSwap(Index, 1, false);
+	Primitives.RemoveAtSwap(Index, 1, false);
+	TrackedComponents.RemoveAtSwap(Index, 1, false);
+	Kinds.RemoveAtSwap(Index, 1, false);
+	LastLocations.RemoveAtSwap(Index, 1, false);
+	LastLocationFrames.RemoveAtSwap(Index, 1, false);
+	Flags.RemoveAtSwap(Index, 1, false);
+	TimesOutside.RemoveAtSwap(Index, 1, false);
+}
+
+int32 FPortalTrackedActors::FindOriginal(const AActor* Actor) const
+{
+	const auto Index = OriginalIndices.Find(Actor);
+	return Index ? *Index : INDEX_NONE;
+}
+
+int32 FPortalTrackedActors::FindClone(const AActor* Actor) const
+{
+	const auto Index = CloneIndices.Find(Actor);
+	return Index ? *Index : INDEX_NONE;
+}
+
+FVector FPortalTrackedActors::GetTrackedLocation(int32 Index) const
+{
+	return TrackedComponents[Index]->GetComponentLocation();
+}
+
+void FPortalTrackedActors::SetLastLocation(int32 Index, const FVector& Location)
+{
+	LastLocations[Index] = Location;
+	LastLocationFrames[Index] = GFrameCounter;
+}
+
+int32 FPortalTrackedActors::Num() const
+{
+	return Originals.Num();
+}
+
+bool FPortalTrackedActors::IsEmpty() const
+{
+	return Originals.IsEmpty();
+}
+
+void FPortalTrackedActors::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObjects(Originals);
+	Collector.AddReferencedObjects(Clones);
+	Collector.AddReferencedObjects(Primitives);
+	Collector.AddReferencedObjects(TrackedComponents);
+}
+
+void FPortalTrackedActors::RemoveIndex(
+	TMap<const AActor*, int32>& Indices,
+	const AActor* Actor,
+	int32 Index)
+{
+	if (Actor)
+	{
+		Indices.Remove(Actor);
+		return;
+	}
+
+	for (auto It = Indices.CreateIterator(); It; ++It)
+	{
+		if (It.Value() == Index)
+		{
+			It.RemoveCurrent();
+			return;
+		}
+	}
+}
+
+void FPortalTrackedActors::MoveIndex(
+	TMap<const AActor*, int32>& Indices,
+	const AActor* Actor,
+	int32 From,
+	int32 To)
+{
+	if (Actor)
+	{
+		Indices[Actor] = To;
+		return;
+	}
+
+	for (auto& Pair : Indices)
+	{
+		if (Pair.Value == From)
+		{
+			Pair.Value = To;
+			return;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PortalCharacterMovementComponent.generated.h"
+
+class APortal;
+
+/**
+ * Character movement which passes through portals inside its own move.
+ * When the camera would cross a portal quad during a move, the move is
+ * split at the portal plane and the rest of it continues from the linked
+ * portal in the same movement step.
+ */
+UCLASS()
+class PORTALREVISITED_API UPortalCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	using CrossedPortal =
+		std::optional<std::pair<TObjectPtr<APortal>, double>>;
+
+public:
+	UPortalCharacterMovementComponent();
+
+	void RegisterPortal(TObjectPtr<APortal> Portal);
+	void UnregisterPortal(TObjectPtr<APortal> Portal);
+
+	/** @return true if the actor passes portals by its own movement. */
+	static bool HandlesPortalTraversal(const AActor& Actor);
+
+protected:
+	virtual bool MoveUpdatedComponentImpl(
+		const FVector& Delta,
+		const FQuat& NewRotation,
+		bool bSweep,
+		FHitResult* OutHit = nullptr,
+		ETeleportType Teleport = ETeleportType::None) override;
+
+private:
+	FVector GetTraversalLocation() const;
+	CrossedPortal FindCrossedPortal(const FVector& Delta) const;
+	bool IsCapsuleInPortalThroat(const APortal& Portal) const;
+	/** @return true if the hit is on a portal wall, inside the portal opening. */
+	bool IsHitInPortalOpening(const FHitResult& Hit) const;
+	/**
+	 * Move, passing the walls of the portals only inside their openings.
+	 * The rest of the walls, floors included, still block.
+	 */
+	bool MoveThroughPortalOpenings(
+		const FVector& Delta,
+		const FQuat& NewRotation,
+		bool bSweep,
+		FHitResult* OutHit,
+		ETeleportType Teleport);
+	void TeleportThroughPortal(APortal& Portal);
+
+private:
+	TArray<TObjectPtr<APortal>> Portals;
+	bool bIsMovingThroughPortal;
+};
@@ -22,6 +22,12 @@ public:
 	void UpdateBackPortalClipLocation(const FMatrix& Matrix, APortal* PortalToDraw);
 	void UpdateFrontPortalClipLocation(const FMatrix& ViewProjectionMatrix, APortal* PortalToDraw);
 	static bool CannotSeePortal(const FMatrix& ViewProjectionMatrix, APortal* PortalToDraw);
+	/** Reads no UObject, so it may run off the game thread. */
+	static bool CannotSeePortal(
+		const FMatrix& ViewProjectionMatrix,
+		const FVector& PortalCenter,
+		const FVector& PortalRight,
+		const FVector& PortalUp);
 
 private:
 	TObjectPtr<UMaterialParameterCollection> MatParamCollection;
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+
+class APortal;
+class IPhysicsProxyBase;
+
+/**
+ * Portal rectangle on its host wall, copied to be read
+ * on the physics thread.
+ */
+struct FPortalOpening
+{
+	const IPhysicsProxyBase* HostSurfaceProxy;
+	FVector Location;
+	FVector Forward;
+	FVector Right;
+	FVector Up;
+
+	/** @return the opening of the portal if the portal is placed on a wall. */
+	static std::optional<FPortalOpening> Make(const APortal& Portal);
+
+	/** @return true if the point is on the wall inside the portal rectangle. */
+	bool Contains(const FVector& Point) const;
+};
+
+struct FPortalContactModifierInput : public Chaos::FSimCallbackInput
+{
+	TArray<FPortalOpening> Openings;
+
+	void Reset()
+	{
+		Openings.Reset();
+	}
+};
+
+/**
+ * Disables contacts between bodies and the wall behind a portal when
+ * every contact point of the pair lies inside the portal rectangle, so
+ * bodies fall into the portal without changing their collision profile.
+ */
+class PORTALREVISITED_API FPortalContactModifier :
+	public Chaos::TSimCallbackObject<
+		FPortalContactModifierInput,
+		Chaos::FSimCallbackNoOutput,
+		Chaos::ESimCallbackOptions::ContactModification>
+{
+public:
+	virtual void OnContactModification_Internal(
+		Chaos::FCollisionContactModifier& Modifier) override;
+
+private:
+	/** Latest openings received from the game thread. */
+	TArray<FPortalOpening> Openings;
+};
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCanvas;
+class APlayerController;
+
+/** Each is shown only while its portal.Debug.<Category> is set. */
+enum class EPortalDebugCategory : uint8
+{
+	General,
+	Frames,
+	ClipCorners,
+	Clones,
+	Num
+};
+
+/**
+ * On-screen debug text which allocates nothing once created, so it
+ * doesn't distort the timings it shows. Lines are formatted into
+ * preallocated slots: a keyed line overwrites its own slot, and any
+ * other line takes the oldest slot of a ring. Game thread only.
+ * Shipping builds keep none of it.
+ */
+class PORTALREVISITED_API FPortalDebugOverlay
+{
+public:
+	/** A line without a key, kept in the ring. */
+	static constexpr int32 NO_KEY = INDEX_NONE;
+
+#if UE_BUILD_SHIPPING
+	static bool IsEnabled(EPortalDebugCategory Category) { return false; }
+	static void Shutdown() {}
+#else
+	static bool IsEnabled(EPortalDebugCategory Category);
+	/** Stop drawing and free the lines. Called on module shutdown. */
+	static void Shutdown();
+#endif
+
+	/**
+	 * @param Key Identifies the line within the category, e.g. the
+	 * unique id of the object it is about.
+	 */
+	template<typename FmtType, typename... ArgTypes>
+	static void Printf(
+		EPortalDebugCategory Category,
+		int32 Key,
+		const FmtType& Format,
+		ArgTypes... Args)
+	{
+#if !UE_BUILD_SHIPPING
+		if (!IsEnabled(Category))
+			return;
+
+		const auto Text = Get().AcquireLine(Category, Key);
+		FCString::Snprintf(Text, TEXT_LENGTH, Format, Args...);
+#endif
+	}
+
+private:
+	static constexpr int32 TEXT_LENGTH = 128;
+	static constexpr int32 KEYED_SLOTS = 32;
+	static constexpr int32 RING_SLOTS = 32;
+
+	struct FLine
+	{
+		TCHAR Text[TEXT_LENGTH];
+		double ExpireSeconds = 0.0;
+		int32 Key = NO_KEY;
+		EPortalDebugCategory Category = EPortalDebugCategory::General;
+	};
+
+	FPortalDebugOverlay();
+	~FPortalDebugOverlay();
+
+	static FPortalDebugOverlay& Get();
+	static void Draw(UCanvas* Canvas, APlayerController* PlayerController);
+
+	/** @return the buffer of the slot the line is written to. */
+	TCHAR* AcquireLine(EPortalDebugCategory Category, int32 Key);
+	void DrawLines(UCanvas& Canvas) const;
+
+	FLine KeyedLines[KEYED_SLOTS];
+	FLine RingLines[RING_SLOTS];
+	int32 NextRingIndex;
+	FDelegateHandle DrawHandle;
+};
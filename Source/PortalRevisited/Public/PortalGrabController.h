@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "PortalSnapshot.h"
+
+class FSingleParticlePhysicsProxy;
+
+struct FPortalGrabInput : public Chaos::FSimCallbackInput
+{
+	/** The grabbed body, or nullptr if nothing is grabbed. */
+	FSingleParticlePhysicsProxy* Proxy = nullptr;
+	/** Distinguishes grabs, so a cancel is not applied to a newer grab. */
+	uint32 GrabId = 0;
+	/** true if the body is on the other side of the portal in view. */
+	bool bAcrossedPortal = false;
+
+	/** The view segment the body is held along. */
+	FVector ViewStart;
+	FVector ViewEnd;
+	/** Where the body is held, without passing any portal. */
+	FVector TargetLocation;
+	double MaxDistance = 0.0;
+	double VelocityMultiplier = 0.0;
+
+	/** Only valid if bHasPortals. */
+	bool bHasPortals = false;
+	FPortalFrame First;
+	FPortalFrame Second;
+
+	void Reset()
+	{
+		Proxy = nullptr;
+		GrabId = 0;
+		bAcrossedPortal = false;
+		bHasPortals = false;
+	}
+};
+
+struct FPortalGrabOutput : public Chaos::FSimCallbackOutput
+{
+	/** The grab the physics thread let go, or 0. */
+	uint32 CanceledGrabId = 0;
+
+	void Reset()
+	{
+		CanceledGrabId = 0;
+	}
+};
+
+/**
+ * Holds the grabbed body in front of the view on the physics thread.
+ * The velocity toward the target is recomputed before every physics
+ * step, and the target is moved through the portal the view segment
+ * crosses analytically, so no scene query runs to keep holding it.
+ */
+class PORTALREVISITED_API FPortalGrabController :
+	public Chaos::TSimCallbackObject<
+		FPortalGrabInput,
+		FPortalGrabOutput,
+		Chaos::ESimCallbackOptions::Presimulate>
+{
+public:
+	virtual void OnPreSimulate_Internal() override;
+
+private:
+	/** @return the target moved through the portal in view, if any. */
+	std::optional<FVector> GetTargetThroughPortal() const;
+	bool IsInReach(const FVector& Location, const std::optional<FVector>& Target) const;
+	void Cancel();
+
+	/** Latest grab received from the game thread. */
+	FPortalGrabInput Grab;
+	/** Inputs of this grab are ignored until the game thread stops it. */
+	uint32 CanceledGrabId = 0;
+};
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The most verbose portal log compiled in each build configuration.
+ * A log above it compiles to nothing, with its arguments. Below it,
+ * a log is formatted only if its category is that verbose at runtime,
+ * e.g. by "log Portal Verbose".
+ */
+#if UE_BUILD_SHIPPING
+#define PORTAL_LOG_COMPILE_VERBOSITY Warning
+#elif UE_BUILD_TEST
+#define PORTAL_LOG_COMPILE_VERBOSITY Log
+#else
+#define PORTAL_LOG_COMPILE_VERBOSITY All
+#endif
+
+/**
+ * Log from this line at most once per Interval seconds, for paths
+ * run every frame. Skipped logs are not formatted.
+ */
+#define PORTAL_LOG_RATE_LIMITED(CategoryName, Verbosity, Interval, Format, ...) \
+	do \
+	{ \
+		if (UE_LOG_ACTIVE(CategoryName, Verbosity)) \
+		{ \
+			static double PortalLogLastSeconds = -DBL_MAX; \
+			const auto PortalLogSeconds = FPlatformTime::Seconds(); \
+			if (PortalLogSeconds - PortalLogLastSeconds >= (Interval)) \
+			{ \
+				PortalLogLastSeconds = PortalLogSeconds; \
+				UE_LOG(CategoryName, Verbosity, Format, ##__VA_ARGS__); \
+			} \
+		} \
+	} while (0)
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "PortalSnapshot.h"
+
+class IPhysicsProxyBase;
+class FSingleParticlePhysicsProxy;
+
+/** A simulated body in front of a portal of the pair. */
+struct FPortalPhysicsTeleportBody
+{
+	FSingleParticlePhysicsProxy* Proxy;
+	/** true if the body is in front of the first portal of the pair. */
+	bool bAtFirst;
+};
+
+struct FPortalPhysicsTeleportInput : public Chaos::FSimCallbackInput
+{
+	FPortalFrame First;
+	FPortalFrame Second;
+	TArray<FPortalPhysicsTeleportBody> Bodies;
+
+	void Reset()
+	{
+		Bodies.Reset();
+	}
+};
+
+struct FPortalPhysicsTeleportOutput : public Chaos::FSimCallbackOutput
+{
+	/** Bodies teleported on the physics thread, to be handled on the game thread. */
+	TArray<FPortalPhysicsTeleportBody> TeleportedBodies;
+
+	void Reset()
+	{
+		TeleportedBodies.Reset();
+	}
+};
+
+/**
+ * Teleports simulated bodies through a portal pair on the physics thread.
+ * Before every physics step, each body whose motion over the step crosses
+ * its portal has its transform and velocities rewritten to the other
+ * side, so fast throws pass at substep rate regardless of frame rate.
+ */
+class PORTALREVISITED_API FPortalPhysicsTeleport :
+	public Chaos::TSimCallbackObject<
+		FPortalPhysicsTeleportInput,
+		FPortalPhysicsTeleportOutput,
+		Chaos::ESimCallbackOptions::Presimulate>
+{
+public:
+	virtual void OnPreSimulate_Internal() override;
+
+private:
+	/** Latest pair and bodies received from the game thread. */
+	FPortalFrame First;
+	FPortalFrame Second;
+	TArray<FPortalPhysicsTeleportBody> Bodies;
+};
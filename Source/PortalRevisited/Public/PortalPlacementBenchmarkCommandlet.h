@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PortalPlacementSolver.h"
+#include "PortalPlacementBenchmarkCommandlet.generated.h"
+
+/**
+ * Solves randomized portal placements, checks the invariants of each
+ * result and reports solves per second. Needs no map:
+ *
+ * UnrealEditor-Cmd PortalRevisited -run=PortalPlacementBenchmark -Iterations=1000000 -Seed=42
+ *
+ * Returns non-zero if any placement breaks an invariant.
+ */
+UCLASS()
+class PORTALREVISITED_API UPortalPlacementBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPortalPlacementBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/**
+	 * Half of the surfaces are axis aligned, and half of those are given
+	 * as actor bounds. So a quarter of the inputs are on bounds, and the
+	 * rest on baked rectangles.
+	 */
+	static FPortalPlacementInput MakeRandomInput(FRandomStream& Random);
+
+	/** @return the name of the broken invariant, or nullptr. */
+	static const TCHAR* CheckPlacement(
+		const FPortalPlacementInput& Input,
+		const FPortalPlacement& Placement);
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "PortalSurfaceIndex.h"
+
+/** What placing a portal needs, copied on the game thread. */
+struct FPortalPlacementInput
+{
+	FVector ImpactPoint;
+	FVector ImpactNormal;
+	/** The baked surface the portal is placed on, if any. */
+	std::optional<FPortalSurfaceRect> SurfaceRect;
+	/** Bounds of the actor the portal is placed on, without a baked surface. */
+	FVector SurfaceCenter;
+	FVector SurfaceExtent;
+	/** The current rotation of the portal to place. */
+	FQuat PortalQuat;
+	/** Becomes the up vector of a portal on a floor or a ceiling. */
+	FVector CharacterForward;
+};
+
+struct FPortalPlacement
+{
+	FVector Location;
+	FQuat Rotation;
+};
+
+/**
+ * Computes where a portal lands on a surface. Touches no UObject,
+ * so it runs on any thread.
+ */
+class PORTALREVISITED_API FPortalPlacementSolver
+{
+public:
+	/** @return std::nullopt if the portal does not fit on the surface. */
+	static std::optional<FPortalPlacement> Solve(const FPortalPlacementInput& Input);
+
+private:
+	static FQuat CalculatePortalRotation(const FPortalPlacementInput& Input);
+
+	/** @return the offset along U which moves the portal into the bounds. */
+	static std::optional<FVector> MovePortalUAxisAligned(
+		double BoundCenterU,
+		double BoundExtentU,
+		const FVector& PortalRight,
+		const FVector& PortalUp,
+		const FVector& PortalCenter,
+		const FVector& U);
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "PortalProjectileMovementComponent.generated.h"
+
+class APortal;
+
+/**
+ * Projectile movement which passes through portals inside its own move.
+ * Each move is tested against the portal quads of the subsystem, and
+ * when it enters one, the rest of the move continues from the linked
+ * portal. No clone or overlap of the portals is involved.
+ */
+UCLASS()
+class PORTALREVISITED_API UPortalProjectileMovementComponent : public UProjectileMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPortalProjectileMovementComponent();
+
+	/** @return true if the actor passes portals by its own movement. */
+	static bool HandlesPortalTraversal(const AActor& Actor);
+
+	virtual void StopMovementImmediately() override;
+
+	/** Pass through portals, or hit the portals as the walls behind them. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Portal)
+	bool bPassesPortals;
+
+protected:
+	virtual bool MoveUpdatedComponentImpl(
+		const FVector& Delta,
+		const FQuat& NewRotation,
+		bool bSweep,
+		FHitResult* OutHit = nullptr,
+		ETeleportType Teleport = ETeleportType::None) override;
+
+private:
+	void SetIgnoredSurface(UPrimitiveComponent* Surface);
+	/** Stop ignoring the wall of the exited portal once clear of it. */
+	void UpdateIgnoredSurface();
+
+private:
+	/** The wall of the portal the projectile just left. */
+	TObjectPtr<UPrimitiveComponent> IgnoredSurface;
+	TObjectPtr<APortal> ExitedPortal;
+	bool bIsMovingThroughPortal;
+};
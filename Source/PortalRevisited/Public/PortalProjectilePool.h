@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APortalRevisitedProjectile;
+class UInstancedStaticMeshComponent;
+
+/**
+ * A fixed set of portal projectiles, reused round robin, so firing
+ * spawns nothing. The projectiles are either pooled actors, or only
+ * instances of one mesh moved toward their destinations without any
+ * collision.
+ */
+class PORTALREVISITED_API FPortalProjectilePool
+{
+public:
+	void CreateActors(UWorld& World, TSubclassOf<APortalRevisitedProjectile> ProjectileClass);
+	/** @param Speed The distance the projectile moves in a second. */
+	void CreateInstances(AActor& Owner, UStaticMesh* Mesh, const FVector& Scale, float Speed);
+	void Destroy();
+
+	void Fire(const FVector& Location, const FRotator& Rotation, const FVector& Destination);
+	/** Moves the instances. The actors move themselves. */
+	void Tick(float DeltaTime);
+
+private:
+	struct FInstancedProjectile
+	{
+		FVector Start;
+		FVector Destination;
+		FQuat Rotation;
+		float Elapsed;
+		float Duration;
+		bool bIsInUse = false;
+	};
+
+	TArray<TObjectPtr<APortalRevisitedProjectile>> Actors;
+
+	TObjectPtr<UInstancedStaticMeshComponent> Instances;
+	TArray<FInstancedProjectile> InstancedProjectiles;
+	/** Written every tick, to update the instances at once. */
+	TArray<FTransform> InstanceTransforms;
+	FVector InstanceScale;
+	float InstanceSpeed = 0.f;
+
+	int32 NextIndex = 0;
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "Math/VectorRegister.h"
+#include "PortalSnapshot.h"
+
+/** Where a segment enters a portal from its front side. */
+struct FPortalRayHit
+{
+	/** The index of the quad, in the order it was added. */
+	int32 Index;
+	/** The fraction of the segment from the start to the hit. */
+	double Time;
+	FVector Location;
+};
+
+/**
+ * Portal rectangles laid out by component, four portals a block, so
+ * a segment is tested against four portals at once without any scene
+ * query. Lanes left in the last block never hit.
+ */
+class PORTALREVISITED_API FPortalQuads
+{
+public:
+	void Reset();
+	/** @return the index of the added quad. */
+	int32 Add(const FPortalFrame& Frame);
+	int32 Num() const;
+
+	/** @return the nearest portal the segment passes from the front side to the back side. */
+	std::optional<FPortalRayHit> Raycast(
+		const FVector& Start,
+		const FVector& End,
+		TConstArrayView<int32> IgnoredIndices = {}) const;
+
+private:
+	static constexpr int32 LANES = 4;
+
+	/** W holds the dot product of the plane location and the axis. */
+	struct FBlock
+	{
+		double ForwardX[LANES];
+		double ForwardY[LANES];
+		double ForwardZ[LANES];
+		double ForwardW[LANES];
+		double RightX[LANES];
+		double RightY[LANES];
+		double RightZ[LANES];
+		double RightW[LANES];
+		double UpX[LANES];
+		double UpY[LANES];
+		double UpZ[LANES];
+		double UpW[LANES];
+	};
+
+	/** Dot products of a broadcast vector with four axes. */
+	static VectorRegister4Double Dot(
+		const VectorRegister4Double& X,
+		const VectorRegister4Double& Y,
+		const VectorRegister4Double& Z,
+		const double* LaneX,
+		const double* LaneY,
+		const double* LaneZ);
+
+	TArray<FBlock> Blocks;
+	int32 NumQuads = 0;
+};
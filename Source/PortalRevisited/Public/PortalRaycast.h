@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "PortalRayQuery.h"
+#include "PortalSnapshot.h"
+
+class APortal;
+
+struct FPortalRaycastQuery
+{
+	FVector Start;
+	/** Should be normalized. */
+	FVector Direction;
+	double Range;
+	ECollisionChannel Channel;
+	/** How many portals the ray may pass. It stops at the next one. */
+	int32 MaxHops = 1;
+	bool bReturnPhysicalMaterial = false;
+	/** Ignored by the traces, and by the portal test if a portal. */
+	TArray<TObjectPtr<AActor>, TInlineAllocator<2>> IgnoredActors;
+
+	bool operator==(const FPortalRaycastQuery& Other) const;
+};
+
+struct FPortalRaycastResult
+{
+	/** The first hit, in the space after the last hop. */
+	std::optional<FHitResult> Hit;
+
+	/** The portal the ray stopped at, because no hop was left or it leads nowhere. */
+	TObjectPtr<APortal> StoppedPortal;
+	FVector StoppedLocation;
+
+	/** The passed portals, in order. */
+	TArray<TObjectPtr<APortal>, TInlineAllocator<2>> PassedPortals;
+	/** Maps the world at the start to the space after the last hop. */
+	FTransform PortalTransform;
+};
+
+/** The scene trace of a query which passes no portal, to be run elsewhere. */
+struct FPortalRaycastTrace
+{
+	FVector Start;
+	/** Short of the first portal, where the ray would stop. */
+	FVector End;
+	ECollisionChannel Channel;
+	FCollisionQueryParams CollisionParams;
+};
+
+/** Where a segment passes a portal, found without tracing the scene. */
+struct FPortalCrossing
+{
+	TObjectPtr<APortal> Portal;
+	/** The fraction of the segment from the start to the portal. */
+	double Time;
+	FVector Location;
+	FPortalFrame Src;
+	FPortalFrame Dest;
+	TObjectPtr<APortal> DestPortal;
+};
+
+/**
+ * Follows a ray through the portals it enters. Portals are found
+ * analytically, and the scene is traced only between them, for
+ * occluders. The portals and the results are kept for a frame, so
+ * identical queries in a frame share one result.
+ */
+class PORTALREVISITED_API FPortalRaycast
+{
+public:
+	/** @return true if the portals should be added again before a query. */
+	bool IsStale() const;
+	/** Forget the portals and the results, to add the portals of this frame. */
+	void Reset();
+	/** Make the next query add the portals again, as a portal moved. */
+	void Invalidate();
+	/**
+	 * A placed portal of an inactive pair stops the ray, as there is
+	 * nowhere to pass. Unplaced portals are only ignored by the traces.
+	 */
+	void AddPair(TObjectPtr<APortal> First, TObjectPtr<APortal> Second);
+
+	FPortalRaycastResult Raycast(const UWorld& World, const FPortalRaycastQuery& Query);
+	/**
+	 * The trace of a query which passes no portal. Its first hit is
+	 * the hit of Raycast, and no hit means the ray stopped at a
+	 * portal or hit nothing.
+	 */
+	FPortalRaycastTrace MakeTrace(const FPortalRaycastQuery& Query) const;
+	/** @return the nearest portal the segment enters. Nothing else is tested. */
+	std::optional<FPortalCrossing> FindCrossing(const FVector& Start, const FVector& End) const;
+
+private:
+	FPortalRaycastResult Trace(const UWorld& World, const FPortalRaycastQuery& Query) const;
+	FCollisionQueryParams MakeCollisionParams(const FPortalRaycastQuery& Query) const;
+	TArray<int32, TInlineAllocator<2>> GetIgnoredQuads(const FPortalRaycastQuery& Query) const;
+
+	/** Quads of the portals which lead somewhere. */
+	FPortalQuads Quads;
+	TArray<TObjectPtr<APortal>> QuadPortals;
+	TArray<FPortalFrame> QuadFrames;
+	/** The index of the linked portal of each quad, or INDEX_NONE if it leads nowhere. */
+	TArray<int32> QuadLinks;
+	/** Quads which lead nowhere, ignored when looking for crossings. */
+	TArray<int32> UnlinkedQuads;
+	TArray<TObjectPtr<APortal>> AllPortals;
+
+	TArray<FPortalRaycastQuery> Queries;
+	TArray<FPortalRaycastResult> Results;
+
+	std::optional<uint64> Frame;
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PortalTrackedActors.h"
+
+class APortal;
+
+/** Location and basis of a portal, copied on the game thread. */
+struct FPortalFrame
+{
+	FVector PlaneLocation;
+	FQuat Quat;
+	FVector Forward;
+	FVector Right;
+	FVector Up;
+
+	static FPortalFrame Make(const APortal& Portal);
+
+	FVector TransformPointTo(const FPortalFrame& Dest, const FVector& Target) const;
+	FVector TransformVectorTo(const FPortalFrame& Dest, const FVector& Target) const;
+	FQuat TransformQuatTo(const FPortalFrame& Dest, const FQuat& Target) const;
+	/** @return the transform which maps the space in front of this to the space in front of the dest. */
+	FTransform GetTransformTo(const FPortalFrame& Dest) const;
+};
+
+/** What a frame of portal work computes, applied on the game thread. */
+struct FPortalResult
+{
+	/** Clone transforms, indexed by the tracked index. */
+	TArray<FVector> CloneLocations;
+	TArray<FQuat> CloneQuats;
+	/** The first tracked index crossed the portal, or INDEX_NONE. */
+	int32 CrossedIndex = INDEX_NONE;
+	bool bVisible = false;
+
+	void Reset();
+};
+
+/**
+ * Immutable copy of a portal and its tracked actors. Computing it
+ * touches no UObject, so snapshots of many pairs run in parallel.
+ */
+struct FPortalSnapshot
+{
+	FPortalFrame Frame;
+	bool bActivated = false;
+	bool bCheckTraversal = false;
+
+	/** Only compared on commit, to detect entries changed meanwhile. */
+	TArray<TObjectPtr<AActor>> Originals;
+	TArray<FVector> OriginalLocations;
+	TArray<FQuat> OriginalQuats;
+	TArray<FVector> TrackedLocations;
+	TArray<FVector> LastLocations;
+	TArray<uint64> LastLocationFrames;
+	TArray<EPortalTrackedFlags> Flags;
+
+	void Reset();
+
+	/** @param DestFrame The frame of the linked portal. */
+	void Compute(const FPortalFrame& DestFrame, FPortalResult& Result) const;
+	/** Read after the camera update, so the view is of this frame. */
+	bool IsVisibleFrom(const FMatrix& ViewProjectionMatrix) const;
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+/**
+ * Frame costs of the portals, shown by "stat Portal". Every stat is also
+ * written to CSV captures under the Portal category.
+ */
+DECLARE_STATS_GROUP(TEXT("Portal"), STATGROUP_Portal, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Snapshots"), STAT_PortalComputeSnapshots, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Clones"), STAT_PortalUpdateClones, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Traversal"), STAT_PortalTraversal, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Register Overlapping Actor"), STAT_PortalRegisterOverlappingActor, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Clip Location"), STAT_PortalUpdateClipLocation, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Capture"), STAT_PortalUpdateCapture, STATGROUP_Portal, PORTALREVISITED_API);
+/** The capture seen directly, and the capture seen through the linked portal. */
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture Scene (Depth 0)"), STAT_PortalCaptureScene0, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Capture Scene (Depth 1)"), STAT_PortalCaptureScene1, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Solve Placement"), STAT_PortalSolvePlacement, STATGROUP_Portal, PORTALREVISITED_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Captures"), STAT_PortalCaptures, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Skipped Captures"), STAT_PortalSkippedCaptures, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Clones"), STAT_PortalClones, STATGROUP_Portal, PORTALREVISITED_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Teleports"), STAT_PortalTeleports, STATGROUP_Portal, PORTALREVISITED_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(PORTALREVISITED_API, Portal);
+
+/** Time the scope by STAT_Portal<Stat>, and by <Stat> in CSV captures. */
+#define PORTAL_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(STAT_Portal##Stat); \
+	CSV_SCOPED_TIMING_STAT(Portal, Stat)
+
+/** Add to STAT_Portal<Stat>, and to <Stat> in CSV captures, for this frame. */
+#define PORTAL_INC_COUNTER(Stat, Amount) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_Portal##Stat, Amount); \
+		CSV_CUSTOM_STAT(Portal, Stat, static_cast<int32>(Amount), ECsvCustomStatOp::Accumulate); \
+	} while (0)
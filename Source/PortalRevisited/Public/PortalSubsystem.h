@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <optional>
+
+#include "CoreMinimal.h"
+#include "PortalRaycast.h"
+#include "PortalSnapshot.h"
+#include "PortalSurfaceIndex.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PortalSubsystem.generated.h"
+
+class APortal;
+class UPortalSubsystem;
+class FPortalPhysicsTeleport;
+
+/** The player's view, read once per frame for every portal. */
+struct FPortalView
+{
+	FVector Location;
+	FQuat Rotation;
+	FMatrix ProjectionMatrix;
+	FMatrix ViewProjectionMatrix;
+};
+
+USTRUCT()
+struct FPortalPair
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<APortal> First;
+
+	UPROPERTY()
+	TObjectPtr<APortal> Second;
+
+	/** Set if simulated bodies of the pair are teleported on the physics thread. */
+	FPortalPhysicsTeleport* PhysicsTeleport = nullptr;
+};
+
+/** Runs the traversal prediction of the subsystem before physics. */
+USTRUCT()
+struct FPortalPrePhysicsTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UPortalSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(
+		float DeltaTime,
+		ELevelTick TickType,
+		ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FPortalPrePhysicsTickFunction> :
+	public TStructOpsTypeTraitsBase2<FPortalPrePhysicsTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/** Runs the captures of the subsystem after the camera update. */
+USTRUCT()
+struct FPortalPostUpdateTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UPortalSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(
+		float DeltaTime,
+		ELevelTick TickType,
+		ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FPortalPostUpdateTickFunction> :
+	public TStructOpsTypeTraitsBase2<FPortalPostUpdateTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/** A frame of work of an awake pair. */
+struct FPortalPairWork
+{
+	TObjectPtr<APortal> First;
+	TObjectPtr<APortal> Second;
+
+	FPortalSnapshot FirstSnapshot;
+	FPortalSnapshot SecondSnapshot;
+	FPortalResult FirstResult;
+	FPortalResult SecondResult;
+};
+
+/**
+ * Runs the per-frame work of every linked portal pair, once per pair,
+ * in a fixed order: clones, traversal, clip parameters, captures.
+ * A pair with nothing to do on both sides is skipped.
+ *
+ * The pairs are copied into snapshots on the game thread, computed
+ * in parallel, and the results are applied back on the game thread.
+ *
+ * Before physics, crossings predicted from velocities are teleported
+ * in the same frame. The sweep after the update corrects the rest.
+ *
+ * The clip parameters and captures of the awake pairs wait for the
+ * post update work, when the player camera of this frame is known.
+ */
+UCLASS()
+class PORTALREVISITED_API UPortalSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * @param bPhysicsThreadTeleport Teleport simulated bodies of the pair
+	 * on the physics thread instead of the game thread.
+	 */
+	void RegisterPair(
+		TObjectPtr<APortal> First,
+		TObjectPtr<APortal> Second,
+		bool bPhysicsThreadTeleport = false);
+	/** Remove the pair which contains the portal. */
+	void UnregisterPair(TObjectPtr<APortal> Portal);
+
+	/**
+	 * Follow the ray through the portals of every pair. Identical
+	 * queries in a frame share one result.
+	 */
+	FPortalRaycastResult Raycast(const FPortalRaycastQuery& Query);
+	/** The scene trace of a query which passes no portal, to run it asynchronously. */
+	FPortalRaycastTrace MakeRaycastTrace(const FPortalRaycastQuery& Query);
+	/** @return the nearest portal of every pair the segment enters. */
+	std::optional<FPortalCrossing> FindPortalCrossing(const FVector& Start, const FVector& End);
+	/** Should be called when a portal is placed or removed. */
+	void InvalidateRaycasts();
+
+	/** Portalable surfaces of the level, empty if not baked. */
+	const FPortalSurfaceIndex& GetSurfaceIndex() const;
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	virtual void Tick(float DeltaTime) override;
+	void TickPrePhysics(float DeltaTime);
+	void TickPostUpdate(float DeltaTime);
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+
+private:
+	std::optional<FPortalView> GetPlayerView() const;
+	/** Add the portals of this frame to the raycaster, if not yet. */
+	void UpdateRaycaster();
+	/** Set the trace counters of every portal, while the portal channel is on. */
+	void TraceCounters() const;
+	void RegisterPhysicsTeleport(FPortalPair& Pair);
+	void UnregisterPhysicsTeleport(FPortalPair& Pair);
+	/** Hand the pair's bodies to the physics thread and handle what it teleported. */
+	void UpdatePhysicsTeleport(const FPortalPair& Pair);
+	void CommitPair(const FPortalPairWork& Work, float DeltaTime);
+	void CommitCaptures(FPortalPairWork& Work, float DeltaTime, const FPortalView& View);
+
+	UPROPERTY()
+	TArray<FPortalPair> Pairs;
+
+	FPortalPrePhysicsTickFunction PrePhysicsTickFunction;
+	FPortalPostUpdateTickFunction PostUpdateTickFunction;
+
+	/** Kept between frames to reuse the allocations of the snapshots. */
+	TArray<FPortalPairWork> Works;
+	/** The works of this frame, whose captures wait for the post update. */
+	int32 NumPendingWorks = 0;
+
+	FPortalRaycast Raycaster;
+
+	/** Mapped at begin play, for the life of the world. */
+	FPortalSurfaceIndex SurfaceIndex;
+};
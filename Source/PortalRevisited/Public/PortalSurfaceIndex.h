@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/ChaosEngineInterface.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// Surfaces with PM_White.
+constexpr auto WHITE_SURFACE = EPhysicalSurface::SurfaceType1;
+
+/** A planar rectangle a portal can be placed on, as stored in the index. */
+struct FPortalSurfaceRect
+{
+	FVector3f Center;
+	FVector3f Normal;
+	FVector3f Right;
+	FVector3f Up;
+	float HalfRight;
+	float HalfUp;
+};
+
+/**
+ * Portalable surfaces of a level, baked by UPortalSurfaceIndexCommandlet.
+ * The file is memory-mapped and read in place, so loading costs nothing
+ * but the mapping.
+ */
+class PORTALREVISITED_API FPortalSurfaceIndex
+{
+public:
+	FPortalSurfaceIndex();
+	~FPortalSurfaceIndex();
+
+	/** @return the file the index of the map is baked into. */
+	static FString GetIndexPath(const FString& MapName);
+	static bool Save(const FString& Path, TConstArrayView<FPortalSurfaceRect> Rects);
+
+	/** @return false if the map has no index, or the file is broken. */
+	bool Load(const FString& Path);
+	void Unload();
+	bool IsLoaded() const;
+
+	/** @return the surface which contains the point and faces the normal. */
+	const FPortalSurfaceRect* FindSurface(const FVector& Point, const FVector& Normal) const;
+
+private:
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 NumRects;
+		uint32 Padding;
+	};
+
+	static constexpr uint32 MAGIC = 0x58495350; // "PSIX"
+	static constexpr uint32 VERSION = 1;
+
+	bool SetRects(const uint8* Data, int64 Size);
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	/** Only used where the file cannot be mapped, as in a pak. */
+	TArray<uint8> LoadedData;
+
+	TConstArrayView<FPortalSurfaceRect> Rects;
+};
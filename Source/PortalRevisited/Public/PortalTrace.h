@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "Trace/Trace.h"
+
+/**
+ * Portal events in Unreal Insights, recorded with
+ * -trace=cpu,bookmark,counters,portal. Scopes time the costly steps,
+ * and bookmarks mark activations, clones and teleports on the timeline.
+ */
+UE_TRACE_CHANNEL_EXTERN(PortalChannel, PORTALREVISITED_API);
+
+#define PORTAL_TRACE_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, PortalChannel)
+
+/** For names built at runtime. Costs more than PORTAL_TRACE_SCOPE. */
+#define PORTAL_TRACE_SCOPE_TEXT(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(Name, PortalChannel)
+
+/** The bookmark is formatted only while the channel is on. */
+#define PORTAL_TRACE_BOOKMARK(Format, ...) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(PortalChannel)) \
+		{ \
+			TRACE_BOOKMARK(Format, ##__VA_ARGS__); \
+		} \
+	} while (0)
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FReferenceCollector;
+
+enum class EPortalTrackedKind : uint8
+{
+	/** The player character. Tracked by the first person camera. */
+	Player,
+	/** Any other actor. Tracked by the root component. */
+	Body,
+};
+
+enum class EPortalTrackedFlags : uint8
+{
+	None = 0,
+	/**
+	 * The actor is passed through the portal by its own movement,
+	 * or by the physics thread.
+	 */
+	HandlesTraversal = 1 << 0,
+	/** The actor left the enter mask but its clone is retained. */
+	Leaving = 1 << 1,
+};
+ENUM_CLASS_FLAGS(EPortalTrackedFlags);
+
+/**
+ * Actors overlapping a portal and their clones on the linked side.
+ * Every entry is stored in parallel arrays indexed by the same tracked
+ * index, so per-frame work runs over contiguous data. Membership of
+ * originals and clones is looked up in O(1), which is only needed
+ * by overlap events.
+ *
+ * The owner reports the entries to the garbage collector, which nulls
+ * the entries of destroyed actors until the owner releases them.
+ */
+struct PORTALREVISITED_API FPortalTrackedActors
+{
+	TArray<TObjectPtr<AActor>> Originals;
+	TArray<TObjectPtr<AActor>> Clones;
+	TArray<TObjectPtr<UPrimitiveComponent>> Primitives;
+	/** The component whose location is swept for crossings. */
+	TArray<TObjectPtr<USceneComponent>> TrackedComponents;
+	TArray<EPortalTrackedKind> Kinds;
+	TArray<FVector> LastLocations;
+	/** GFrameCounter when the last location was swept. */
+	TArray<uint64> LastLocationFrames;
+	TArray<EPortalTrackedFlags> Flags;
+	/** Seconds spent beyond the exit margin while leaving. */
+	TArray<float> TimesOutside;
+
+	/** @return the tracked index of the new entry. */
+	int32 Add(
+		TObjectPtr<AActor> Original,
+		TObjectPtr<UPrimitiveComponent> Primitive,
+		TObjectPtr<USceneComponent> TrackedComponent,
+		EPortalTrackedKind Kind,
+		EPortalTrackedFlags NewFlags);
+
+	void SetClone(int32 Index, TObjectPtr<AActor> Clone);
+	void ClearClone(int32 Index);
+
+	/** Remove the entry by moving the last entry into its index. */
+	void RemoveAtSwap(int32 Index);
+
+	/** @return the tracked index or INDEX_NONE. */
+	int32 FindOriginal(const AActor* Actor) const;
+	/** @return the tracked index or INDEX_NONE. */
+	int32 FindClone(const AActor* Actor) const;
+
+	FVector GetTrackedLocation(int32 Index) const;
+	void SetLastLocation(int32 Index, const FVector& Location);
+
+	int32 Num() const;
+	bool IsEmpty() const;
+
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	/** The actor may have been nulled by the collector, so the index is searched then. */
+	static void RemoveIndex(TMap<const AActor*, int32>& Indices, const AActor* Actor, int32 Index);
+	static void MoveIndex(TMap<const AActor*, int32>& Indices, const AActor* Actor, int32 From, int32 To);
+
+	TMap<const AActor*, int32> OriginalIndices;
+	TMap<const AActor*, int32> CloneIndices;
+};
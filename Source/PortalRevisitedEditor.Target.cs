@@ -11,5 +11,6 @@ public class PortalRevisitedEditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_1;
 		ExtraModuleNames.Add("PortalRevisited");
+		ExtraModuleNames.Add("PortalRevisitedEditor");
 	}
 }
@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PortalSurfaceIndexCommandlet.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "PhysicsEngine/BodySetup.h"
+
+DEFINE_LOG_CATEGORY_STATIC(PortalEditor, Log, All);
+
+UPortalSurfaceIndexCommandlet::UPortalSurfaceIndexCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UPortalSurfaceIndexCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const auto MapsParam = ParamVals.Find(TEXT("Maps"));
+	if (!MapsParam)
+	{
+		UE_LOG(PortalEditor, Error, TEXT("Usage: -run=PortalSurfaceIndex -Maps=/Game/Map1+/Game/Map2"));
+		return 1;
+	}
+
+	TArray<FString> Maps;
+	MapsParam->ParseIntoArray(Maps, TEXT("+"));
+
+	int32 NumFailed = 0;
+	for (const auto& Map : Maps)
+	{
+		const auto Package = LoadPackage(nullptr, *Map, LOAD_None);
+		const auto World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+		if (!World)
+		{
+			UE_LOG(PortalEditor, Error, TEXT("Cannot load the map: %s"), *Map);
+			++NumFailed;
+			continue;
+		}
+
+		TArray<FPortalSurfaceRect> Rects;
+		CollectSurfaces(*World, Rects);
+
+		const auto Path =
+			FPortalSurfaceIndex::GetIndexPath(FPackageName::GetShortName(Map));
+
+		if (!FPortalSurfaceIndex::Save(Path, Rects))
+		{
+			UE_LOG(PortalEditor, Error, TEXT("Cannot save the portal surface index: %s"), *Path);
+			++NumFailed;
+			continue;
+		}
+
+		UE_LOG(PortalEditor, Display, TEXT("Baked %d portal surfaces of %s into %s"), Rects.Num(), *Map, *Path);
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+void UPortalSurfaceIndexCommandlet::CollectSurfaces(
+	const UWorld& World,
+	TArray<FPortalSurfaceRect>& Rects)
+{
+	for (const auto Level : World.GetLevels())
+	{
+		if (!Level)
+			continue;
+
+		for (const auto Actor : Level->Actors)
+		{
+			if (!Actor)
+				continue;
+
+			TInlineComponentArray<UStaticMeshComponent*> Components(Actor);
+			for (const auto Component : Components)
+			{
+				const auto StaticMesh = Component->GetStaticMesh();
+				if (!StaticMesh)
+					continue;
+
+				// Traces return the simple collision material.
+				const auto PhysicalMaterial =
+					Component->BodyInstance.GetSimplePhysicalMaterial();
+				if (!PhysicalMaterial || PhysicalMaterial->SurfaceType != WHITE_SURFACE)
+					continue;
+
+				const auto ComponentTransform = GetWorldTransform(*Component);
+
+				const auto BodySetup = StaticMesh->GetBodySetup();
+				if (BodySetup && !BodySetup->AggGeom.BoxElems.IsEmpty())
+				{
+					for (const auto& Box : BodySetup->AggGeom.BoxElems)
+					{
+						AddBoxFaces(
+							Box.GetTransform() * ComponentTransform,
+							FVector(Box.X, Box.Y, Box.Z) * 0.5,
+							Rects);
+					}
+				}
+				else
+				{
+					const auto Bounds = StaticMesh->GetBoundingBox();
+					AddBoxFaces(
+						FTransform(Bounds.GetCenter()) * ComponentTransform,
+						Bounds.GetExtent(),
+						Rects);
+				}
+			}
+		}
+	}
+}
+
+void UPortalSurfaceIndexCommandlet::AddBoxFaces(
+	const FTransform& BoxTransform,
+	const FVector& BoxExtent,
+	TArray<FPortalSurfaceRect>& Rects)
+{
+	const auto WorldExtent = BoxTransform.GetScale3D().GetAbs() * BoxExtent;
+
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		const auto RightAxis = (Axis + 1) % 3;
+		const auto UpAxis = (Axis + 2) % 3;
+
+		FVector LocalNormal(0.0);
+		LocalNormal[Axis] = 1.0;
+		FVector LocalRight(0.0);
+		LocalRight[RightAxis] = 1.0;
+		FVector LocalUp(0.0);
+		LocalUp[UpAxis] = 1.0;
+
+		for (const auto Sign : { 1.0, -1.0 })
+		{
+			const auto Normal =
+				BoxTransform.TransformVectorNoScale(LocalNormal * Sign);
+
+			FPortalSurfaceRect Rect;
+			Rect.Center = FVector3f(
+				BoxTransform.TransformPosition(LocalNormal * Sign * BoxExtent[Axis]));
+			Rect.Normal = FVector3f(Normal);
+			Rect.Right = FVector3f(BoxTransform.TransformVectorNoScale(LocalRight));
+			Rect.Up = FVector3f(BoxTransform.TransformVectorNoScale(LocalUp));
+			Rect.HalfRight = WorldExtent[RightAxis];
+			Rect.HalfUp = WorldExtent[UpAxis];
+
+			Rects.Add(Rect);
+		}
+	}
+}
+
+FTransform UPortalSurfaceIndexCommandlet::GetWorldTransform(const USceneComponent& Component)
+{
+	auto Transform = Component.GetRelativeTransform();
+
+	for (auto Parent = Component.GetAttachParent(); Parent; Parent = Parent->GetAttachParent())
+	{
+		Transform = Transform * Parent->GetRelativeTransform();
+	}
+
+	return Transform;
+}
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PortalSurfaceIndex.h"
+#include "PortalSurfaceIndexCommandlet.generated.h"
+
+/**
+ * Bakes the surfaces with PM_White of each map into a portal surface
+ * index, one rectangle per face of the box collisions, or of the
+ * bounds of meshes without one. Should be run before cooking:
+ *
+ * UnrealEditor-Cmd PortalRevisited -run=PortalSurfaceIndex -Maps=/Game/L_Chamber1
+ *
+ * Maps are separated by '+'. The index files are staged as
+ * non-asset content. Lives in the editor module, so it does not
+ * ship in game builds.
+ */
+UCLASS()
+class PORTALREVISITEDEDITOR_API UPortalSurfaceIndexCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPortalSurfaceIndexCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	static void CollectSurfaces(const UWorld& World, TArray<FPortalSurfaceRect>& Rects);
+	static void AddBoxFaces(
+		const FTransform& BoxTransform,
+		const FVector& BoxExtent,
+		TArray<FPortalSurfaceRect>& Rects);
+	/** Components of a loaded level are not registered, so walk the attachment. */
+	static FTransform GetWorldTransform(const USceneComponent& Component);
+};